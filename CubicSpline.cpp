@@ -1,61 +1,141 @@
 //implementation of CubicSpline.h
 #include "CubicSpline.h"
+#include "prototypes.h"
+#include "numeric.h"
+
+//setValues solves for this many second derivatives on either side of the ones whose equations changed
+//each row of the spline's system is diagonally dominant by a factor of 2, so the effect of a change
+//shrinks by at least half with every row, and after 64 rows it is below the rounding error of the solve
+#define SPLINE_UPDATE_MARGIN 64
 
 //constructs a natural cubic spline from points
-//each cubic we make is defined by four constants: a_i, b_i, c_i, d_i
 CubicSpline::CubicSpline(std::vector<std::pair<double, double>> points)
 {
-  std::sort(points.begin(), points.end()); //points must be in order for this algorithm
+  build(orderSpectrum(std::move(points), 1).points); //points must be in order for this algorithm
+}
+
+//constructs a natural cubic spline from data
+//data that is in descending order only has to be reversed, and data that is in neither order is sorted
+CubicSpline::CubicSpline(const spectrum& data)
+{
+  if(data.order == 1)
+    build(data.points);
+  else if(data.order == -1)
+    build(std::vector<std::pair<double, double>>(data.points.rbegin(), data.points.rend()));
+  else
+    build(orderSpectrum(data.points, 1).points);
+}
 
+//fits the cubics to points, which must be in ascending order
+//each cubic we make is defined by four constants: a_i, b_i, c_i, d_i
+void CubicSpline::build(const std::vector<std::pair<double, double>>& points)
+{
   //how many cubics we're going to make
   int n = points.size()-1;
+  if(n < 2)
+    throw nmrException{NMR_INVALID_DATA, "a spline needs at least 3 points, but there are " + std::to_string(points.size())};
 
   xValues.reserve(n+1);
-  cubics.reserve(n);
+  yValues.reserve(n+1);
+  cubics.resize(n);
+  localCubics.resize(n);
 
   for(int i = 0; i <= n; i++)
+  {
     xValues.push_back(points[i].first);
+    yValues.push_back(points[i].second);
+  }
 
   //h contains the difference between consecutive x-values
-  arma::vec h(n, arma::fill ::zeros);
+  std::vector<double> h(n);
   for(int i = 0; i < n; i++)
-    h(i) = points[i+1].first - points[i].first;
+    h[i] = points[i+1].first - points[i].first;
 
   //alpha is a vector representing the constants on the right side of our system of linear equations
-  arma::vec alpha(n+1, arma::fill ::zeros);
+  std::vector<double> alpha(n+1, 0.0);
   for(int i = 1; i < n; i++)
-    alpha(i) = 3/h[i]*(points[i+1].second - points[i].second) - 3/h[i-1]*(points[i].second - points[i-1].second);
+    alpha[i] = 3/h[i]*(points[i+1].second - points[i].second) - 3/h[i-1]*(points[i].second - points[i-1].second);
 
-  //A is a matrix representing the coefficients in our system of linear equations
-  arma::mat A(n+1, n+1, arma::fill ::zeros);
-  A(0,0) = 1.0;
-  A(n,n) = 1.0;
+  //A is the tridiagonal matrix of coefficients in our system of linear equations, stored as its three diagonals
+  //the first and last rows say the spline is natural
+  std::vector<double> lower(n, 0.0), diagonal(n+1, 1.0), upper(n, 0.0);
   for(int i = 1; i < n; i++)
   {
-    A(i,i-1) = h[i-1];
-    A(i,i) = 2*(h[i-1]+h[i]);
-    A(i,i+1) = h[i];
+    lower[i-1] = h[i-1];
+    diagonal[i] = 2*(h[i-1]+h[i]);
+    upper[i] = h[i];
   }
 
   //solve A*c = alpha for c
   //c contains all our c_i constants
-  arma::vec c = solve(A, alpha);
+  std::vector<double> c = solveTridiagonal(lower, diagonal, upper, alpha);
 
   for(int i = 0; i < n; i++)
+    setCubic(i, c[i], c[i+1]);
+}
+
+//makes the ith cubic from the y-values and the constants c_i and c_(i+1)
+void CubicSpline::setCubic(int i, double c_i, double c_next)
+{
+  double h = xValues[i+1] - xValues[i];
+  //calculate all the constants that define the ith cubic
+  double a_i = yValues[i];
+  double b_i = (yValues[i+1] - yValues[i])/h - h*(c_next+2*c_i)/3;
+  double d_i = (c_next-c_i)/(3*h);
+  //the x-values of the input points
+  double x_i = xValues[i];
+
+  //construct the ith cubic p
+  FixedPolynomial<1> diff = {-x_i, 1}; // (x - x_i)
+  FixedPolynomial<3> p = a_i + b_i*diff + c_i*diff.power<2>() + d_i*diff.power<3>();
+  cubics[i] = p;
+  localCubics[i] = {a_i, b_i, c_i, d_i};
+}
+
+//replaces the y-values of the points first, first+1, ..., counted in ascending order of x
+//only the equations for c_(first-1) to c_(last+1) change, so the system is solved again on a window around them,
+//with the c_i just outside the window held at their old values, and only the cubics that use the new c_i are refitted
+//returns the first and last index of the cubics that were refitted
+std::pair<int, int> CubicSpline::setValues(int first, const std::vector<double>& ys)
+{
+  int n = cubics.size();
+  int last = first + int(ys.size()) - 1;
+  for(int k = 0; k < ys.size(); k++)
+    yValues[first+k] = ys[k];
+
+  //c_0 and c_n are always 0 for a natural spline, so the window is at most rows 1 to n-1
+  int lo = std::max(1, first - 1 - SPLINE_UPDATE_MARGIN);
+  int hi = std::min(n-1, last + 1 + SPLINE_UPDATE_MARGIN);
+  //c[k] is c_(lo-1+k), starting with the value held fixed below the window and ending with the one above it
+  std::vector<double> c(hi - lo + 3, 0.0);
+  c.front() = localCubics[lo-1][2];
+  c.back() = hi+1 < n ? localCubics[hi+1][2] : 0;
+
+  if(lo <= hi)
   {
-    //calculate all the constants that define the ith cubic
-    double a_i = points[i].second;
-    double b_i = (points[i+1].second - points[i].second)/h[i] - h[i]*(c(i+1)+2*c(i))/3;
-    double c_i = c(i);
-    double d_i = (c(i+1)-c(i))/(3*h[i]);
-    //the x-values of the input points
-    double x_i = points[i].first;
-
-    //construct the ith cubic p
-    Polynomial diff = {-x_i, 1}; // (x - x_i)
-    Polynomial p = a_i + b_i*diff + c_i*diff.power(2) + d_i*diff.power(3);
-    cubics.push_back(p);
+    int m = hi - lo + 1;
+    std::vector<double> lower(m-1), diagonal(m), upper(m-1), alpha(m);
+    for(int i = lo; i <= hi; i++)
+    {
+      double hBefore = xValues[i] - xValues[i-1], hAfter = xValues[i+1] - xValues[i];
+      alpha[i-lo] = 3/hAfter*(yValues[i+1] - yValues[i]) - 3/hBefore*(yValues[i] - yValues[i-1]);
+      diagonal[i-lo] = 2*(hBefore + hAfter);
+      if(i > lo)
+        lower[i-lo-1] = hBefore;
+      else
+        alpha[0] -= hBefore*c.front();
+      if(i < hi)
+        upper[i-lo] = hAfter;
+      else
+        alpha[m-1] -= hAfter*c.back();
+    }
+    std::vector<double> solution = solveTridiagonal(lower, diagonal, upper, alpha);
+    std::copy(solution.begin(), solution.end(), c.begin() + 1);
   }
+
+  for(int i = lo-1; i <= hi; i++)
+    setCubic(i, c[i-lo+1], c[i-lo+2]);
+  return {lo-1, hi};
 }
 
 //gets how many cubic have been stitched together
@@ -65,11 +145,18 @@ int CubicSpline::getNumCubics() const
 }
 
 //get the ith cubic polynomial
-Polynomial CubicSpline::operator[](int i) const
+const FixedPolynomial<3>& CubicSpline::operator[](int i) const
 {
   return cubics[i];
 }
 
+//get the ith cubic polynomial in terms of t = x - x_i, where x_i is the start of its range
+//its coefficients are much better scaled than the ith cubic's when x_i is far from 0
+const FixedPolynomial<3>& CubicSpline::getLocalCubic(int i) const
+{
+  return localCubics[i];
+}
+
 //get the range of x values that the ith cubic is valid over
 std::pair<double, double> CubicSpline:: getRange(int i) const
 {
@@ -113,6 +200,37 @@ int CubicSpline::findIndex(double x, int left, int right) const
 //evaluate the cubic spline at x
 double CubicSpline::evaluate(double x) const
 {
-  Polynomial p = cubics[findIndex(x)];
-  return p.evaluate(x);
+  return cubics[findIndex(x)].evaluate(x);
+}
+
+//evaluate the cubic spline at every x in xs, which must be sorted in ascending order
+std::vector<double> CubicSpline::evaluate(const std::vector<double>& xs) const
+{
+  std::vector<double> result;
+  evaluate(xs, result);
+  return result;
+}
+
+//evaluate the cubic spline at every x in xs, which must be sorted in ascending order, and store the results in ys
+//walks through the cubics in order instead of searching for each x
+void CubicSpline::evaluate(const std::vector<double>& xs, std::vector<double>& ys) const
+{
+  ys.resize(xs.size());
+  evaluate(xs.data(), xs.size(), ys.data());
+}
+
+//evaluate the cubic spline at the n x-values starting at xs, which must be sorted in ascending order
+//the results are stored starting at ys, so the buffers can come from anywhere
+void CubicSpline::evaluate(const double* xs, int n, double* ys) const
+{
+  if(n == 0)
+    return;
+
+  int i = findIndex(xs[0]);
+  for(int k = 0; k < n; k++)
+  {
+    while(i < cubics.size()-1 && xs[k] > xValues[i+1])
+      i++;
+    ys[k] = cubics[i].evaluate(xs[k]);
+  }
 }
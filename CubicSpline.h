@@ -1,33 +1,53 @@
 //class for a cubic spline
 #include "Polynomial.h"
+#include "FixedPolynomial.h"
+#include "structs.h"
 #include <limits>
 #include <algorithm>
-#include <armadillo>
 #pragma once
 
 class CubicSpline
 {
   private:
     //the cubics that make up the spline
-    std::vector<Polynomial> cubics;
+    std::vector<FixedPolynomial<3>> cubics;
+    //the same cubics written in terms of t = x - x_i, where x_i is the start of their range
+    std::vector<FixedPolynomial<3>> localCubics;
     //the x-values at which the cubics are stitched together
     std::vector<double> xValues;
+    //the y-values the spline passes through at each of xValues
+    std::vector<double> yValues;
 
-    //returns the index of the cubic that x would be evaluated with
-    int findIndex(double x) const;
     //helper function to perform binary search
     int findIndex(double x, int left, int right) const;
+    //fits the cubics to points, which must be in ascending order
+    void build(const std::vector<std::pair<double, double>>& points);
+    //makes the ith cubic from the y-values and the second derivatives c_i and c_(i+1) divided by 2
+    void setCubic(int i, double c_i, double c_next);
   public:
-    //constructs a natural cubic spline from points
+    //constructs a natural cubic spline from points, which are put in order first if they aren't already
     CubicSpline(std::vector<std::pair<double, double>> points);
+    //constructs a natural cubic spline from data, using its order instead of checking it again
+    CubicSpline(const spectrum& data);
+    //returns the index of the cubic that x would be evaluated with
+    int findIndex(double x) const;
     //gets how many cubics have been stitched together
     int getNumCubics() const;
     //get the ith cubic polynomial
-    Polynomial operator[](int i) const;
+    const FixedPolynomial<3>& operator[](int i) const;
+    //get the ith cubic polynomial in terms of t = x - x_i, where x_i is the start of its range
+    const FixedPolynomial<3>& getLocalCubic(int i) const;
     //get the range of x values that the ith cubic is valid over
     std::pair<double, double> getRange(int i) const;
     //evaluate the cubic spline at x
     double evaluate(double x) const;
-
-    friend std::string gnuPrint(CubicSpline c);
+    //evaluate the cubic spline at every x in xs, which must be sorted in ascending order
+    std::vector<double> evaluate(const std::vector<double>& xs) const;
+    //same as above, but stores the results in ys so its memory can be reused between calls
+    void evaluate(const std::vector<double>& xs, std::vector<double>& ys) const;
+    //same as above, for the n x-values starting at xs, with ys big enough to hold n results
+    void evaluate(const double* xs, int n, double* ys) const;
+    //replaces the y-values of the points first, first+1, ..., counted in ascending order of x, and refits only the cubics near them
+    //returns the first and last index of the cubics that were refitted
+    std::pair<int, int> setValues(int first, const std::vector<double>& ys);
 };
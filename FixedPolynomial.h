@@ -0,0 +1,163 @@
+//class template for a polynomial whose degree is known at compile time
+//the coefficients are stored inline, so unlike Polynomial nothing here touches the heap
+//used for the cubics of a CubicSpline and their derivatives
+#pragma once
+#include <array>
+#include <initializer_list>
+#include <cmath>
+
+template <int N>
+class FixedPolynomial
+{
+  private:
+    //the coefficients of each term are stored in order of ascending degree
+    //for example ax^3+bx^2+cx+d is stored as [d,c,b,a]
+    std::array<double, N+1> coefficients;
+
+  public:
+    //default constructor creates the polynomial 0
+    constexpr FixedPolynomial() : coefficients{} {}
+
+    //constructs a polynomial where args are the coefficients listed from lowest to highest degree
+    //missing higher degree coefficients are 0
+    constexpr FixedPolynomial(std::initializer_list<double> args) : coefficients{}
+    {
+      int i = 0;
+      for(double a : args)
+        if(i <= N)
+          coefficients[i++] = a;
+    }
+
+    //constructs a polynomial where args are the coefficients listed from lowest to highest degree
+    constexpr FixedPolynomial(std::array<double, N+1> args) : coefficients(args) {}
+
+    constexpr std::array<double, N+1> getCoefficients() const
+    {
+      return coefficients;
+    }
+
+    constexpr double operator[](int i) const
+    {
+      return coefficients[i];
+    }
+
+    constexpr double& operator[](int i)
+    {
+      return coefficients[i];
+    }
+
+    //the degree is always N, even if the leading coefficient is 0
+    constexpr int getDegree() const
+    {
+      return N;
+    }
+
+    //returns the polynomial evaluated at a specific x value using Horner's method
+    constexpr double evaluate(double x) const
+    {
+      double result = coefficients[N];
+      for(int i = N-1; i >= 0; i--)
+        result = result*x + coefficients[i];
+      return result;
+    }
+
+    //returns the derivative of the polynomial
+    constexpr FixedPolynomial<(N > 0 ? N-1 : 0)> derivative() const
+    {
+      FixedPolynomial<(N > 0 ? N-1 : 0)> result;
+      //power rule: shift each coefficient down a degree and multiply by its old power
+      for(int i = 1; i <= N; i++)
+        result[i-1] = i*coefficients[i];
+      return result;
+    }
+
+    //finds a root of the polynomial using Newton's Method with an initial approximation of p0
+    double root(double p0) const
+    {
+      const int MAX_ITERATIONS = 10000;
+      const double TOLERANCE = 0.00000000001;
+
+      auto fPrime = derivative();
+      for(int i = 1; i <= MAX_ITERATIONS; i++)
+      {
+        double p = p0 - evaluate(p0)/fPrime.evaluate(p0);
+        if(fabs(p - p0) < TOLERANCE)
+          return p;
+        p0 = p;
+      }
+      return p0;
+    }
+
+    //raises the polynomial to the power K
+    template <int K>
+    constexpr FixedPolynomial<N*K> power() const
+    {
+      FixedPolynomial<N*K> result = {1};
+      for(int k = 0; k < K; k++)
+      {
+        FixedPolynomial<N*K> product;
+        //only the terms below degree N*(k+1) can be nonzero at this point
+        for(int i = 0; i <= N*k; i++)
+          for(int j = 0; j <= N; j++)
+            product[i+j] += result[i]*coefficients[j];
+        result = product;
+      }
+      return result;
+    }
+};
+
+//adds two polynomials
+template <int N, int M>
+constexpr FixedPolynomial<(N > M ? N : M)> operator+(FixedPolynomial<N> a, FixedPolynomial<M> b)
+{
+  FixedPolynomial<(N > M ? N : M)> result;
+  for(int i = 0; i <= N; i++)
+    result[i] += a[i];
+  for(int i = 0; i <= M; i++)
+    result[i] += b[i];
+  return result;
+}
+
+//multiplies two polynomials
+template <int N, int M>
+constexpr FixedPolynomial<N+M> operator*(FixedPolynomial<N> a, FixedPolynomial<M> b)
+{
+  FixedPolynomial<N+M> result;
+  for(int i = 0; i <= N; i++)
+    for(int j = 0; j <= M; j++)
+      result[i+j] += a[i]*b[j];
+  return result;
+}
+
+//multiplies a polynomial by a constant
+template <int N>
+constexpr FixedPolynomial<N> operator*(double scalar, FixedPolynomial<N> p)
+{
+  for(int i = 0; i <= N; i++)
+    p[i] *= scalar;
+  return p;
+}
+
+//adds a constant to a polynomial
+template <int N>
+constexpr FixedPolynomial<N> operator+(double scalar, FixedPolynomial<N> p)
+{
+  p[0] += scalar;
+  return p;
+}
+
+//divides a polynomial by a constant
+template <int N>
+constexpr FixedPolynomial<N> operator/(FixedPolynomial<N> p, double scalar)
+{
+  for(int i = 0; i <= N; i++)
+    p[i] /= scalar;
+  return p;
+}
+
+//subtracts two polynomials
+template <int N, int M>
+constexpr FixedPolynomial<(N > M ? N : M)> operator-(FixedPolynomial<N> a, FixedPolynomial<M> b)
+{
+  return a + (-1*b);
+}
@@ -0,0 +1,124 @@
+//implementation of NoiseEstimate.h
+//the median absolute deviation is the median of |v - m| over the values v, where m is their median
+//the values at or below m give m - v in descending order of v and the ones above it give v - m in ascending order,
+//so it is the middle of two sorted sequences, which a binary search finds with a few lookups into the blocks
+#include "NoiseEstimate.h"
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <limits>
+
+NoiseEstimate::NoiseEstimate(const std::vector<std::pair<double, double>>& data)
+{
+  std::vector<double> values;
+  for(auto & point : data)
+    if(point.second < 0)
+      values.push_back(point.second);
+  std::sort(values.begin(), values.end());
+  count = values.size();
+  for(int i = 0; i < count; i += NOISE_BLOCK_SIZE)
+    blocks.emplace_back(values.begin() + i, values.begin() + std::min(count, i + NOISE_BLOCK_SIZE));
+}
+
+int NoiseEstimate::findBlock(double value) const
+{
+  auto block = std::lower_bound(blocks.begin(), blocks.end(), value, [](const std::vector<double>& b, double v){ return b.back() < v; });
+  return std::min(int(block - blocks.begin()), int(blocks.size()) - 1);
+}
+
+double NoiseEstimate::at(int rank) const
+{
+  int b = int(std::upper_bound(starts.begin(), starts.end(), rank) - starts.begin()) - 1;
+  return blocks[b][rank - starts[b]];
+}
+
+int NoiseEstimate::countAtMost(double value) const
+{
+  auto block = std::upper_bound(blocks.begin(), blocks.end(), value, [](double v, const std::vector<double>& b){ return v < b.back(); });
+  if(block == blocks.end())
+    return count;
+  int b = block - blocks.begin();
+  return starts[b] + int(std::upper_bound(block->begin(), block->end(), value) - block->begin());
+}
+
+void NoiseEstimate::insert(double value)
+{
+  count++;
+  if(blocks.empty())
+  {
+    blocks.push_back({value});
+    return;
+  }
+  int b = findBlock(value);
+  std::vector<double>& block = blocks[b];
+  block.insert(std::upper_bound(block.begin(), block.end(), value), value);
+  //a block that has grown too big is split in two, so inserting into it stays cheap
+  if(block.size() > 2*NOISE_BLOCK_SIZE)
+  {
+    std::vector<double> upper(block.begin() + NOISE_BLOCK_SIZE, block.end());
+    block.resize(NOISE_BLOCK_SIZE);
+    blocks.insert(blocks.begin() + b + 1, std::move(upper));
+  }
+}
+
+//the value is always one that was inserted, so it is in the first block that could hold it
+void NoiseEstimate::erase(double value)
+{
+  count--;
+  int b = findBlock(value);
+  std::vector<double>& block = blocks[b];
+  block.erase(std::lower_bound(block.begin(), block.end(), value));
+  if(block.empty())
+    blocks.erase(blocks.begin() + b);
+}
+
+void NoiseEstimate::replace(double oldValue, double newValue)
+{
+  if(oldValue < 0)
+    erase(oldValue);
+  if(newValue < 0)
+    insert(newValue);
+}
+
+double NoiseEstimate::estimate(double& noiseFloor)
+{
+  starts.clear();
+  int total = 0;
+  for(auto & block : blocks)
+  {
+    starts.push_back(total);
+    total += block.size();
+  }
+  noiseFloor = 0;
+  if(count == 0)
+    return 0;
+
+  //the same element estimateNoise picks with nth_element
+  int k = count/2;
+  double median = at(k);
+  noiseFloor = median;
+  int numBelow = countAtMost(median), numAbove = count - numBelow;
+  auto below = [&](int i){ return median - at(numBelow - 1 - i); };
+  auto above = [&](int j){ return at(numBelow + j) - median; };
+
+  //finds how many of the k+1 smallest deviations are at or below the median
+  int taken = k + 1;
+  int low = std::max(0, taken - numAbove), high = std::min(taken, numBelow);
+  while(true)
+  {
+    int i = (low + high)/2, j = taken - i;
+    if(i < numBelow && j > 0 && above(j-1) > below(i))
+      low = i + 1;
+    else if(i > 0 && j < numAbove && below(i-1) > above(j))
+      high = i - 1;
+    else
+    {
+      double deviation = -std::numeric_limits<double>::infinity();
+      if(i > 0)
+        deviation = std::max(deviation, below(i-1));
+      if(j > 0)
+        deviation = std::max(deviation, above(j-1));
+      return MAD_SCALE*deviation;
+    }
+  }
+}
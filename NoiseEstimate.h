@@ -0,0 +1,37 @@
+//class for the noise estimate of estimateNoise, kept up to date as the intensities of a spectrum change
+//the points below the baseline are kept sorted in blocks, so a changed point only moves the values of one block
+//and the medians are found by counting through the blocks instead of selecting from every point again
+#pragma once
+#include <vector>
+#include <utility>
+
+//scales the median absolute deviation to the standard deviation of gaussian noise
+#define MAD_SCALE 1.4826
+//how many values a block starts with, and it is split once it has twice as many
+#define NOISE_BLOCK_SIZE 512
+
+class NoiseEstimate
+{
+  private:
+    //the negative intensities in ascending order, split into blocks
+    std::vector<std::vector<double>> blocks;
+    //how many values come before each block, brought up to date by estimate
+    std::vector<int> starts;
+    int count;
+
+    //the index of the first block whose largest value is at least value, or the last block if there isn't one
+    int findBlock(double value) const;
+    //the value with rank values smaller than it
+    double at(int rank) const;
+    //how many values are at most value
+    int countAtMost(double value) const;
+    void insert(double value);
+    void erase(double value);
+  public:
+    //starts from the intensities of data
+    NoiseEstimate(const std::vector<std::pair<double, double>>& data);
+    //changes an intensity of the spectrum from oldValue to newValue
+    void replace(double oldValue, double newValue);
+    //the same as estimateNoise on the current intensities, including noiseFloor
+    double estimate(double& noiseFloor);
+};
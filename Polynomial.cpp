@@ -60,13 +60,13 @@ int Polynomial::getDegree() const
   return coefficients.size() - 1;
 }
 
-//returns the polynomial evaluated at a specific x value
+//returns the polynomial evaluated at a specific x value using Horner's method
 double Polynomial::evaluate(double x) const
 {
   double result = 0;
-  for(int i = 0; i <= getDegree(); i++)
+  for(int i = getDegree(); i >= 0; i--)
   {
-    result += coefficients[i]*pow(x,i);
+    result = result*x + coefficients[i];
   }
   return result;
 }
@@ -0,0 +1,24 @@
+//runs the whole analysis on a set of data points
+#include "CubicSpline.h"
+#include "structs.h"
+#include "prototypes.h"
+#include "arena.h"
+
+//filters the data, fits a cubic spline to it and finds its peaks according to the options in config
+//shift is set to the x-value of the TMS peak
+//the temporary buffers of every stage come from one arena, which is released all at once when the analysis is done
+std::vector<peak> analyze(std::vector<std::pair<double, double>> data, configuration config, double& shift)
+{
+  ArenaScope arena;
+  spectrum ordered = orderSpectrum(std::move(data), -1, config.numThreads);  //order the data from most positive to most negative, it's only sorted if it has to be
+  shift = 0;
+  //adjusting and filtering the data keep it in the same order, so the spline doesn't have to sort it again
+  baselineAdjustment(ordered, config.baseline, config.baselineMode, shift); //adjust the data based on baseline and find TMS
+  ordered.points = filter(std::move(ordered.points), config.filterType, config.filterSize, config.numPasses, config.precision);
+  CubicSpline spline(ordered); //construct a cubic spline from the data
+  auto peaks = calculatePeaks(spline, ordered.points, config.integrationTechnique, config.tolerance, config.quadratureOrder, config.kronrodOrder, config.minSnr); //calculate the peak values, leaving out noise
+  peaks = findApexes(peaks, spline, config.peakDetection, config.integrationTechnique, config.tolerance, config.quadratureOrder, config.kronrodOrder); //find the apex of each peak
+  peaks = fitPeaks(peaks, ordered.points, config.peakModel, config.numThreads); //fit line shapes to the peaks
+  shiftPeaks(peaks, ordered.xOffset); //the data was never shifted, so shift the peaks so that TMS is at x=0
+  return peaks;
+}
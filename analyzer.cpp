@@ -0,0 +1,171 @@
+//implementation of nmr.h
+//the analysis reports errors by throwing an nmrException, which stops here and becomes an errorCode
+#include "nmr.h"
+#include "structs.h"
+#include "prototypes.h"
+#include "arena.h"
+#include "incremental.h"
+#include <string>
+#include <vector>
+#include <new>
+#include <exception>
+#include <cmath>
+
+//space reserved in the arena for each point of the spectrum, enough for the buffers of every stage
+#define ARENA_BYTES_PER_POINT 64
+
+template <typename F>
+errorCode Analyzer::guard(F f)
+{
+  try
+  {
+    f();
+  }
+  catch(const nmrException& e)
+  {
+    error = e.message;
+    return e.code;
+  }
+  catch(const std::bad_alloc&)
+  {
+    error = "out of memory";
+    return NMR_OUT_OF_MEMORY;
+  }
+  //anything else thrown is a bug, but it is still reported instead of ending the program
+  catch(const std::exception& e)
+  {
+    error = std::string("internal error: ") + e.what();
+    return NMR_NUMERICAL;
+  }
+  error.clear();
+  return NMR_OK;
+}
+
+Analyzer::Analyzer() = default;
+Analyzer::~Analyzer() = default;
+Analyzer::Analyzer(Analyzer&&) = default;
+Analyzer& Analyzer::operator=(Analyzer&&) = default;
+
+//new options also end an incremental analysis, since its results were found with the old ones
+errorCode Analyzer::configure(const configuration& config)
+{
+  return guard([&]{
+    validateConfig(config);
+    this->config = config;
+    incremental.reset();
+  });
+}
+
+errorCode Analyzer::configure(std::string fileName)
+{
+  return guard([&]{
+    config = readConfig(fileName);
+    incremental.reset();
+  });
+}
+
+errorCode Analyzer::configure(int argc, char* argv[])
+{
+  return guard([&]{
+    config = parseOptions(argc, argv);
+    incremental.reset();
+  });
+}
+
+const configuration& Analyzer::getConfig() const
+{
+  return config;
+}
+
+//throws an invalid data error if data can't be analyzed
+void checkData(const std::vector<std::pair<double, double>>& data)
+{
+  //a spline needs at least two cubics, and one point that isn't a number would spread through all of them
+  if(data.size() < 3)
+    throw nmrException{NMR_INVALID_DATA, "the spectrum has " + std::to_string(data.size()) + " points, at least 3 are needed"};
+  for(auto & point : data)
+    if(!std::isfinite(point.first) || !std::isfinite(point.second))
+      throw nmrException{NMR_INVALID_DATA, "the spectrum has a point that isn't a finite number"};
+}
+
+errorCode Analyzer::analyze(const std::vector<std::pair<double, double>>& data, std::vector<peak>& peaks, double& shift)
+{
+  return guard([&]{
+    checkData(data);
+    //the arena only grows, so a run on a spectrum no bigger than the last one doesn't allocate it again
+    if(arenaBuffer.size() < ARENA_BYTES_PER_POINT*data.size())
+      arenaBuffer.resize(ARENA_BYTES_PER_POINT*data.size());
+    ArenaScope arena(arenaBuffer.data(), arenaBuffer.size());
+    peaks = ::analyze(data, config, shift);
+  });
+}
+
+errorCode Analyzer::analyzeIncremental(const std::vector<std::pair<double, double>>& data, std::vector<peak>& peaks, double& shift)
+{
+  incremental.reset();
+  return guard([&]{
+    checkData(data);
+    if(arenaBuffer.size() < ARENA_BYTES_PER_POINT*data.size())
+      arenaBuffer.resize(ARENA_BYTES_PER_POINT*data.size());
+    ArenaScope arena(arenaBuffer.data(), arenaBuffer.size());
+    incremental = std::make_unique<IncrementalAnalysis>(data, config);
+    peaks = incremental->getPeaks();
+    shift = incremental->getShift();
+  });
+}
+
+//an update that fails part way through leaves the stages out of step with each other, so the incremental analysis is ended
+errorCode Analyzer::update(int first, const std::vector<double>& intensities, std::vector<peak>& peaks, double& shift)
+{
+  errorCode code = guard([&]{
+    if(!incremental)
+      throw nmrException{NMR_INVALID_DATA, "no spectrum is being analyzed incrementally"};
+    if(first < 0 || first + intensities.size() > incremental->size())
+      throw nmrException{NMR_INVALID_DATA, "the updated points are outside the spectrum"};
+    for(double y : intensities)
+      if(!std::isfinite(y))
+        throw nmrException{NMR_INVALID_DATA, "the spectrum has a point that isn't a finite number"};
+
+    ArenaScope arena(arenaBuffer.data(), arenaBuffer.size());
+    incremental->update(first, intensities);
+    peaks = incremental->getPeaks();
+    shift = incremental->getShift();
+  });
+  if(code != NMR_OK && code != NMR_INVALID_DATA)
+    incremental.reset();
+  return code;
+}
+
+errorCode Analyzer::analyzeFile(std::vector<peak>& peaks, double& shift)
+{
+  std::vector<std::pair<double, double>> data;
+  errorCode code = guard([&]{ data = readData(config.inputFile); });
+  if(code != NMR_OK)
+    return code;
+  return analyze(data, peaks, shift);
+}
+
+errorCode Analyzer::report(const std::vector<peak>& peaks, double shift, double runtime, std::string& result)
+{
+  return guard([&]{ result = formatResult(peaks, config, shift, runtime); });
+}
+
+errorCode Analyzer::writeReport(const std::string& result)
+{
+  return guard([&]{ writeResult(result, config.outputFile); });
+}
+
+errorCode Analyzer::analyzeFiles(const std::vector<std::string>& dataFiles, std::function<void(const fileResult&)> onResult, pipelineStats& stats)
+{
+  return guard([&]{ ::analyzeFiles(config, dataFiles, onResult, stats); });
+}
+
+errorCode Analyzer::watch(std::string directory, const std::atomic<bool>& stop, std::function<void(const fileResult&)> onResult, pipelineStats& stats)
+{
+  return guard([&]{ watchDirectory(config, directory, stop, onResult, stats); });
+}
+
+const std::string& Analyzer::lastError() const
+{
+  return error;
+}
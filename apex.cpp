@@ -0,0 +1,196 @@
+//functions to find the apex of each peak from the derivative of the cubic spline
+//the critical points and inflection points of every cubic are found in closed form from its local coefficients
+//peaks made of several lines can be split at the local minima between them
+#include "structs.h"
+#include "CubicSpline.h"
+#include "prototypes.h"
+#include "arena.h"
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <memory_resource>
+
+//a multiplet is split at a local minimum that is lower than this fraction of the shorter apex on either side of it
+#define SPLIT_FRACTION 0.75
+//bisection steps used to find where the spline crosses half of an apex, enough to reach machine precision
+#define LEVEL_ITERATIONS 64
+
+//a point inside a peak region where the spline's derivative is 0
+struct criticalPoint
+{
+  double x, value;
+  bool isMaximum;
+};
+
+//finds every critical point and inflection point of the spline on [begin,end], in ascending order
+void findShape(const CubicSpline& spline, double begin, double end, std::pmr::vector<criticalPoint>& criticalPoints, std::pmr::vector<double>& inflections)
+{
+  int first = spline.findIndex(begin);
+  int last = spline.findIndex(end);
+  for(int i = first; i <= last; i++)
+  {
+    const FixedPolynomial<3>& q = spline.getLocalCubic(i);
+    std::pair<double, double> range = spline.getRange(i);
+    double h = range.second - range.first;
+    //the part of the cubic inside the peak, in local coordinates
+    double tBegin = std::max(begin, range.first) - range.first;
+    double tEnd = std::min(end, range.second) - range.first;
+
+    double points[2];
+    int numPoints = findCriticalPoints(q, h, points);
+    for(int j = 0; j < numPoints; j++)
+    {
+      if(points[j] < tBegin || points[j] > tEnd)
+        continue;
+      double secondDerivative = 2*q[2] + 6*q[3]*points[j];
+      criticalPoints.push_back({range.first + points[j], q.evaluate(points[j]), secondDerivative < 0});
+    }
+
+    //q''(t) = 2c + 6dt is 0 at a single point
+    if(q[3] != 0)
+    {
+      double t = -q[2]/(3*q[3]);
+      if(tBegin <= t && t <= tEnd && 0 < t && t < h)
+        inflections.push_back(range.first + t);
+    }
+  }
+}
+
+//finds where the spline crosses level between from and to, searching from from towards to
+//the spline is above level at from; returns to if it never drops below level
+double findLevelCrossing(const CubicSpline& spline, double from, double to, double level)
+{
+  int step = to > from ? 1 : -1;
+  int first = spline.findIndex(from);
+  int last = spline.findIndex(to);
+  for(int i = first; step*(last - i) >= 0; i += step)
+  {
+    const FixedPolynomial<3>& q = spline.getLocalCubic(i);
+    std::pair<double, double> range = spline.getRange(i);
+    //the part of this cubic between from and to, in the direction of the search
+    double near = (step > 0 ? std::max(from, range.first) : std::min(from, range.second)) - range.first;
+    double far = (step > 0 ? std::min(to, range.second) : std::max(to, range.first)) - range.first;
+    if(q.evaluate(far) >= level)
+      continue;
+
+    //the spline is above level at near and below it at far, so bisect between them
+    //it can dip below and come back up inside one cubic, but only by less than the noise in the data
+    for(int iteration = 0; iteration < LEVEL_ITERATIONS; iteration++)
+    {
+      double mid = (near + far)/2;
+      if(q.evaluate(mid) >= level)
+        near = mid;
+      else
+        far = mid;
+    }
+    return range.first + (near + far)/2;
+  }
+  return to;
+}
+
+//splits the critical points criticalPoints[first..last] at local minima deep enough to separate two lines
+//the boundaries of the pieces are added to splits
+void splitMultiplet(const std::pmr::vector<criticalPoint>& criticalPoints, int first, int last, std::pmr::vector<double>& splits)
+{
+  //the deepest minimum in the range and the tallest maximum on either side of it
+  int deepest = -1;
+  for(int i = first; i <= last; i++)
+    if(!criticalPoints[i].isMaximum && (deepest == -1 || criticalPoints[i].value < criticalPoints[deepest].value))
+      deepest = i;
+  if(deepest == -1)
+    return;
+
+  double leftApex = 0, rightApex = 0;
+  for(int i = first; i < deepest; i++)
+    if(criticalPoints[i].isMaximum)
+      leftApex = std::max(leftApex, criticalPoints[i].value);
+  for(int i = deepest+1; i <= last; i++)
+    if(criticalPoints[i].isMaximum)
+      rightApex = std::max(rightApex, criticalPoints[i].value);
+
+  //a minimum below the baseline would already have been a zero crossing
+  double minimum = criticalPoints[deepest].value;
+  if(minimum <= 0 || minimum >= SPLIT_FRACTION*std::min(leftApex, rightApex))
+    return;
+
+  splitMultiplet(criticalPoints, first, deepest-1, splits);
+  splits.push_back(criticalPoints[deepest].x);
+  splitMultiplet(criticalPoints, deepest+1, last, splits);
+}
+
+//fills in the apex, height, full width at half maximum and inflection points of a peak
+void describePeak(peak& p, const CubicSpline& spline, const std::pmr::vector<criticalPoint>& criticalPoints, const std::pmr::vector<double>& inflections)
+{
+  //the apex is the tallest maximum, or the middle of the peak if the spline has none inside it
+  p.location = (p.begin + p.end)/2;
+  p.height = spline.evaluate(p.location);
+  for(auto & point : criticalPoints)
+  {
+    if(point.isMaximum && p.begin <= point.x && point.x <= p.end && point.value > p.height)
+    {
+      p.location = point.x;
+      p.height = point.value;
+    }
+  }
+
+  double left = findLevelCrossing(spline, p.location, p.begin, p.height/2);
+  double right = findLevelCrossing(spline, p.location, p.end, p.height/2);
+  p.width = right - left;
+
+  //the inflection points closest to the apex on either side
+  p.leftInflection = p.begin;
+  p.rightInflection = p.end;
+  for(double x : inflections)
+  {
+    if(p.leftInflection < x && x < p.location)
+      p.leftInflection = x;
+    if(p.location < x && x < p.rightInflection)
+      p.rightInflection = x;
+  }
+}
+
+//finds the apex of every peak from the spline's derivative according to peakDetection
+//(0=midpoint of the zero crossings, 1=apex, 2=apex and split multiplets)
+//split peaks are integrated again with integrationTechnique and their hydrogens are recounted
+std::vector<peak> findApexes(std::vector<peak> peaks, const CubicSpline& spline, int peakDetection, int integrationTechnique, double tolerance, int quadratureOrder, int kronrodOrder)
+{
+  if(peakDetection == 0)
+    return peaks;
+
+  std::vector<peak> result;
+  result.reserve(peaks.size());
+  bool split = false;
+  for(peak & p : peaks)
+  {
+    std::pmr::vector<criticalPoint> criticalPoints(scratch());
+    std::pmr::vector<double> inflections(scratch());
+    findShape(spline, p.begin, p.end, criticalPoints, inflections);
+
+    std::pmr::vector<double> splits(scratch());
+    if(peakDetection == 2)
+      splitMultiplet(criticalPoints, 0, int(criticalPoints.size())-1, splits);
+
+    if(splits.empty())
+    {
+      describePeak(p, spline, criticalPoints, inflections);
+      result.push_back(p);
+      continue;
+    }
+
+    //each line of the multiplet becomes its own peak
+    split = true;
+    splits.insert(splits.begin(), p.begin);
+    splits.push_back(p.end);
+    for(int i = 0; i+1 < splits.size(); i++)
+    {
+      peak line = p;
+      line.begin = splits[i];
+      line.end = splits[i+1];
+      line.area = integrate(line.begin, line.end, spline, integrationTechnique, tolerance, quadratureOrder, kronrodOrder);
+      describePeak(line, spline, criticalPoints, inflections);
+      result.push_back(line);
+    }
+  }
+
+  return split ? countHydrogens(result) : result;
+}
@@ -0,0 +1,26 @@
+//implementation of arena.h
+#include "arena.h"
+#include <memory_resource>
+
+//each thread has its own arena, so jobs running on different threads never share one
+thread_local std::pmr::memory_resource* currentArena = nullptr;
+
+std::pmr::memory_resource* scratch()
+{
+  return currentArena ? currentArena : std::pmr::get_default_resource();
+}
+
+ArenaScope::ArenaScope(std::size_t initialSize) : blocks(initialSize, scratch()), pool(&blocks), previous(currentArena)
+{
+  currentArena = &pool;
+}
+
+ArenaScope::ArenaScope(void* buffer, std::size_t size) : blocks(buffer, size, scratch()), pool(&blocks), previous(currentArena)
+{
+  currentArena = &pool;
+}
+
+ArenaScope::~ArenaScope()
+{
+  currentArena = previous;
+}
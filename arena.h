@@ -0,0 +1,33 @@
+//an arena for the short lived buffers of one run of the analysis
+//while an ArenaScope is alive, temporary buffers on its thread are carved out of a few large blocks
+//and all of them are released at once when it ends, instead of each one going through the global allocator
+#pragma once
+#include <memory_resource>
+
+//the size of the first block the arena gets, later blocks grow geometrically from it
+#define ARENA_INITIAL_SIZE (1 << 16)
+
+//the memory resource temporary buffers should be allocated from
+//it's the arena of the innermost ArenaScope on this thread, or the global heap if there isn't one
+std::pmr::memory_resource* scratch();
+
+class ArenaScope
+{
+  private:
+    //the large blocks everything is carved out of, only released when the scope ends
+    std::pmr::monotonic_buffer_resource blocks;
+    //hands freed buffers back out, so buffers that grow or are made once per peak don't use up the blocks
+    std::pmr::unsynchronized_pool_resource pool;
+    //the scratch resource of this thread before the scope started
+    std::pmr::memory_resource* previous;
+  public:
+    //makes a new arena the scratch resource of this thread
+    //its blocks come from the arena of the scope it is inside of, if there is one
+    ArenaScope(std::size_t initialSize = ARENA_INITIAL_SIZE);
+    //same as above, but the arena starts with buffer, which it doesn't own, so the same memory can be reused for every run
+    ArenaScope(void* buffer, std::size_t size);
+    //releases everything allocated from the arena and restores the previous scratch resource
+    ~ArenaScope();
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+};
@@ -1,29 +1,188 @@
+//functions for adjusting the baseline of the data
+//the baseline can be a constant, or it can be estimated automatically so a drifting baseline doesn't need manual tuning
 #include <vector>
 #include <utility>
+#include <algorithm>
+#include <cmath>
+#include "prototypes.h"
+#include "numeric.h"
 
-//shifts all the data so that the TMS peak is at x=0
-std::vector<std::pair<double, double>> baselineAdjustment(std::vector<std::pair<double, double>> data, double baseline, double& shift)
+//degree of the polynomial fitted to the baseline
+#define BASELINE_DEGREE 3
+//points more than this many standard deviations above the fitted polynomial are treated as peaks and left out of the next fit
+#define BASELINE_REJECTION 2.0
+#define BASELINE_ITERATIONS 20
+//smoothness and asymmetry of the asymmetric least squares baseline
+//points above the baseline get weight ALS_ASYMMETRY and points below it get weight 1-ALS_ASYMMETRY
+#define ALS_LAMBDA 1e7
+#define ALS_ASYMMETRY 0.001
+#define ALS_ITERATIONS 10
+
+//fills the diagonals of D^T*D for n points, where D takes second differences, so row j of D is 1,-2,1 at j,j+1,j+2
+//d0 is the main diagonal, d1 the one above it and d2 the one above that
+//each entry adds up the products of the coefficients of the differences that actually include both points,
+//which at the ends of a short spectrum is fewer than in the middle of a long one
+void secondDifferencePenalty(int n, std::vector<double>& d0, std::vector<double>& d1, std::vector<double>& d2)
+{
+  const double coefficients[3] = {1, -2, 1};
+  d0.assign(n, 0.0);
+  d1.assign(std::max(n-1, 0), 0.0);
+  d2.assign(std::max(n-2, 0), 0.0);
+  for(int j = 0; j+2 < n; j++)
+    for(int k = 0; k < 3; k++)
+    {
+      d0[j+k] += coefficients[k]*coefficients[k];
+      if(k < 2)
+        d1[j+k] += coefficients[k]*coefficients[k+1];
+      if(k == 0)
+        d2[j] += coefficients[0]*coefficients[2];
+    }
+}
+
+//estimates the baseline with asymmetric least squares (a Whittaker smoother with asymmetric weights)
+//each iteration minimizes sum w_i (y_i - z_i)^2 + lambda * sum (second difference of z)^2,
+//which is a pentadiagonal system, so every iteration is O(n)
+std::vector<double> alsBaseline(const std::vector<double>& y)
+{
+  int n = y.size();
+  if(n < 3)
+    return y;
+
+  //the diagonals of lambda * D^T*D, where D takes second differences
+  std::vector<double> p0, p1, p2;
+  secondDifferencePenalty(n, p0, p1, p2);
+  for(auto & p : {&p0, &p1, &p2})
+    for(double & value : *p)
+      value *= ALS_LAMBDA;
+
+  std::vector<double> w(n, 1.0), z(n);
+  for(int iteration = 0; iteration < ALS_ITERATIONS; iteration++)
+  {
+    std::vector<double> d0(n), b(n);
+    for(int i = 0; i < n; i++)
+    {
+      d0[i] = p0[i] + w[i];
+      b[i] = w[i]*y[i];
+    }
+    z = solvePentadiagonal(d0, p1, p2, b);
+
+    //peaks are above the baseline, so they get almost no weight in the next iteration
+    bool changed = false;
+    for(int i = 0; i < n; i++)
+    {
+      double weight = y[i] > z[i] ? ALS_ASYMMETRY : 1 - ALS_ASYMMETRY;
+      changed = changed || weight != w[i];
+      w[i] = weight;
+    }
+    if(!changed)
+      break;
+  }
+  return z;
+}
+
+//estimates the baseline by fitting a polynomial to the points that aren't part of a peak
+//after each fit, points far above it are dropped and the polynomial is fitted again
+std::vector<double> polynomialBaseline(const std::vector<double>& x, const std::vector<double>& y)
 {
+  int n = x.size();
+  int m = BASELINE_DEGREE + 1;
+  if(n < m)
+    return std::vector<double>(n, 0.0);
+
+  //fit in terms of u in [-1,1] so the normal equations stay well conditioned
+  double minX = *std::min_element(x.begin(), x.end());
+  double maxX = *std::max_element(x.begin(), x.end());
+  double scale = maxX > minX ? 2/(maxX - minX) : 1;
 
-  //find the TMS peak
-  //assumes the data is sorted from greatest to least by x-value
-  for(auto & point : data)
+  std::vector<bool> included(n, true);
+  std::vector<double> coefficients, fit(n);
+  for(int iteration = 0; iteration < BASELINE_ITERATIONS; iteration++)
   {
-    if(point.second >= baseline)
+    //normal equations of the least squares fit to the included points
+    std::vector<double> A(m*m, 0.0), b(m, 0.0), powers(2*m-1);
+    for(int k = 0; k < n; k++)
     {
-      shift = point.first;
+      if(!included[k])
+        continue;
+      double u = (x[k] - minX)*scale - 1;
+      powers[0] = 1;
+      for(int j = 1; j < 2*m-1; j++)
+        powers[j] = powers[j-1]*u;
+      for(int i = 0; i < m; i++)
+      {
+        b[i] += powers[i]*y[k];
+        for(int j = 0; j < m; j++)
+          A[i*m+j] += powers[i+j];
+      }
+    }
+    if(!solveLinearSystem(A, b, m, coefficients))
       break;
+
+    //evaluate the fit and the spread of the included points around it
+    double sumSquares = 0;
+    int count = 0;
+    for(int k = 0; k < n; k++)
+    {
+      double u = (x[k] - minX)*scale - 1;
+      fit[k] = 0;
+      for(int i = m-1; i >= 0; i--)
+        fit[k] = fit[k]*u + coefficients[i];
+      if(included[k])
+      {
+        sumSquares += (y[k] - fit[k])*(y[k] - fit[k]);
+        count++;
+      }
+    }
+    double sigma = sqrt(sumSquares/count);
+
+    //only points above the fit can be peaks
+    bool changed = false;
+    for(int k = 0; k < n; k++)
+    {
+      bool include = y[k] - fit[k] <= BASELINE_REJECTION*sigma;
+      changed = changed || include != included[k];
+      included[k] = include;
     }
+    if(!changed)
+      break;
   }
+  return fit;
+}
 
-  //shift all the data horiztonally so the TMS peak is at x=0
-  //additionally shift all data down so that the baseline is at y=0
-  //we do this so that the integrals will be the area between the spline and the baseline
-  for(auto & point : data)
+//shifts the data so that the TMS peak is at x=0 and the baseline is at y=0, in place
+//baselineMode chooses the baseline (0=constant, 1=polynomial, 2=asymmetric least squares)
+//the automatic baselines are subtracted first, and then baseline is subtracted as a constant from what is left
+//the x-values aren't touched, the shift is added to data.xOffset instead
+//data must be sorted from greatest to least by x-value
+void baselineAdjustment(spectrum& data, double baseline, int baselineMode, double& shift)
+{
+  std::vector<std::pair<double, double>>& points = data.points;
+  if(baselineMode != 0)
   {
-    point.first -= shift;
-    point.second -= baseline;
+    std::vector<double> x(points.size()), y(points.size());
+    for(int i = 0; i < points.size(); i++)
+    {
+      x[i] = points[i].first;
+      y[i] = points[i].second;
+    }
+    std::vector<double> estimate = baselineMode == 1 ? polynomialBaseline(x, y) : alsBaseline(y);
+    for(int i = 0; i < points.size(); i++)
+      points[i].second -= estimate[i];
   }
 
-  return data;
+  //shift all data down so that the baseline is at y=0
+  //we do this so that the integrals will be the area between the spline and the baseline
+  //the TMS peak is the first point at or above the baseline, so it is found in the same pass:
+  //the first loop checks every point until it finds it, and the second has nothing to check so it vectorizes
+  auto point = points.begin();
+  for(; point != points.end() && point->second < baseline; ++point)
+    point->second -= baseline;
+  if(point != points.end())
+    shift = point->first;
+  for(; point != points.end(); ++point)
+    point->second -= baseline;
+
+  //shifting every x-value so the TMS peak is at x=0 would be another pass over the data,
+  //and nothing but the reported peaks needs to know where 0 is
+  data.xOffset += shift;
 }
@@ -0,0 +1,187 @@
+//benchmarks for each numerical kernel and for the whole pipeline on synthetic spectra
+//usage: ./nmrBench [maxPoints] [numPeaks] [noiseLevel]
+#include "CubicSpline.h"
+#include "structs.h"
+#include "prototypes.h"
+#include "incremental.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <chrono>
+
+//each benchmark is repeated until it has run for at least this many seconds
+#define MIN_BENCH_TIME 0.25
+//number of points in the spectrum used by the kernel benchmarks
+#define KERNEL_POINTS 1024
+
+//results are written here so the compiler can't optimize the benchmarked calls away
+volatile double sink;
+
+//calls f repeatedly for at least MIN_BENCH_TIME seconds and returns the average time per call in seconds
+template <typename F>
+double timeCall(F f)
+{
+  auto start = std::chrono::high_resolution_clock::now();
+  int calls = 0;
+  std::chrono::duration<double> elapsed;
+  do
+  {
+    f();
+    calls++;
+    elapsed = std::chrono::high_resolution_clock::now() - start;
+  } while(elapsed.count() < MIN_BENCH_TIME);
+  return elapsed.count()/calls;
+}
+
+//prints one line of results; items is the amount of work done by one call, used for the per-item time
+void report(std::string name, int n, double seconds, int items)
+{
+  std::cout << std::left << std::setw(32) << name << std::right
+            << std::setw(10) << n
+            << std::setw(16) << std::scientific << std::setprecision(4) << seconds << " s"
+            << std::setw(14) << std::fixed << std::setprecision(2) << 1e9*seconds/items << " ns/item" << std::defaultfloat << std::endl;
+}
+
+//the threshold used to baseline adjust a synthetic spectrum, a few standard deviations above the noise
+double syntheticBaseline(double noiseLevel)
+{
+  return 20 + 5*noiseLevel;
+}
+
+//runs the same analysis as main on data and returns the number of peaks found
+int runPipeline(std::vector<std::pair<double, double>> data, double baseline, int filterType, int integrationTechnique)
+{
+  configuration config;
+  config.baseline = baseline;
+  config.tolerance = 1e-5;
+  config.filterType = filterType;
+  config.filterSize = 5;
+  config.numPasses = 1;
+  config.integrationTechnique = integrationTechnique;
+  double shift = 0;
+  return analyze(data, config, shift).size();
+}
+
+void benchKernels(int numPeaks, double noiseLevel)
+{
+  const int n = KERNEL_POINTS;
+  auto data = syntheticSpectrum(n, numPeaks, noiseLevel, 335);
+  double shift = 0;
+  spectrum adjusted = {data, -1};
+  baselineAdjustment(adjusted, syntheticBaseline(noiseLevel), 0, shift);
+  data = adjusted.points;
+
+  std::cout << "Kernels (" << n << " points, " << numPeaks << " peaks, noise " << noiseLevel << ")" << std::endl;
+  std::cout << "===============================" << std::endl;
+
+  std::vector<double> xs(n), ys(n);
+  for(int i = 0; i < n; i++)
+  {
+    xs[i] = data[i].first;
+    ys[i] = data[i].second;
+  }
+  report("polynomial baseline", n, timeCall([&]{ sink = polynomialBaseline(xs, ys)[n/2]; }), n);
+  report("asymmetric least squares baseline", n, timeCall([&]{ sink = alsBaseline(ys)[n/2]; }), n);
+  report("boxcar filter (size 5)", n, timeCall([&]{ sink = boxcarFilter(data, 5, 1)[n/2].second; }), n);
+  report("boxcar filter, single precision", n, timeCall([&]{ sink = boxcarFilter(data, 5, 1, 1)[n/2].second; }), n);
+  report("Savitzky-Golay filter (size 11)", n, timeCall([&]{ sink = savitzkyGolayFilter(data, 11, 1)[n/2].second; }), n);
+  report("Savitzky-Golay, single precision", n, timeCall([&]{ sink = savitzkyGolayFilter(data, 11, 1, 1)[n/2].second; }), n);
+  report("DFT filter", n, timeCall([&]{ sink = dftFilter(data)[n/2].second; }), n);
+  report("spline construction", n, timeCall([&]{ CubicSpline s(data); sink = s.getNumCubics(); }), n);
+
+  CubicSpline spline(data);
+
+  //evaluate at random x-values so the binary search in findIndex isn't always taking the same path
+  const int numQueries = 100000;
+  std::vector<double> queries(numQueries);
+  std::mt19937 generator(335);
+  std::uniform_real_distribution<double> uniform(data.back().first, data.front().first);
+  for(auto & x : queries)
+    x = uniform(generator);
+  report("spline evaluate (random x)", numQueries, timeCall([&]{
+    double sum = 0;
+    for(double x : queries)
+      sum += spline.evaluate(x);
+    sink = sum;
+  }), numQueries);
+
+  report("cubic root finding", spline.getNumCubics(), timeCall([&]{ sink = findRoots(spline).size(); }), spline.getNumCubics());
+
+  //integrate over every peak of the spline with each technique
+  auto roots = findRoots(spline);
+  const std::string methods[] = {"adaptive quadrature", "Romberg", "composite Newton-Cotes", "Gaussian quadrature"};
+  for(int technique = 0; technique < 4; technique++)
+  {
+    report(methods[technique], roots.size()/2, timeCall([&]{
+      double sum = 0;
+      for(int i = 0; i+1 < roots.size(); i+=2)
+        sum += integrate(roots[i], roots[i+1], spline, technique, 1e-5, 2, 7);
+      sink = sum;
+    }), std::max<int>(1, roots.size()/2));
+
+    long long evaluations = 0;
+    for(int i = 0; i+1 < roots.size(); i+=2)
+    {
+      int count = 0;
+      integrate(roots[i], roots[i+1], spline, technique, 1e-5, 2, 7, &count);
+      evaluations += count;
+    }
+    std::cout << "    " << evaluations/std::max<int>(1, roots.size()/2) << " spline evaluations per peak" << std::endl;
+  }
+  std::cout << std::endl;
+}
+
+void benchPipeline(int maxPoints, int numPeaks, double noiseLevel)
+{
+  std::cout << "End to end (" << numPeaks << " peaks, noise " << noiseLevel << ", adaptive quadrature)" << std::endl;
+  std::cout << "===============================" << std::endl;
+
+  const std::string filters[] = {"no filter", "boxcar", "Savitzky-Golay", "DFT"};
+  for(int n = 1000; n <= maxPoints; n *= 10)
+  {
+    auto data = syntheticSpectrum(n, numPeaks, noiseLevel, 335);
+    //both include copying the data, which is all that ordering sorted data should cost on top of one pass
+    auto shuffled = data;
+    std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(335));
+    report("ordering, already sorted", n, timeCall([&]{ sink = orderSpectrum(data, -1).points[0].first; }), n);
+    report("ordering, shuffled", n, timeCall([&]{ sink = orderSpectrum(shuffled, -1).points[0].first; }), n);
+    for(int filterType = 0; filterType < 4; filterType++)
+    {
+      std::string name = "pipeline, " + filters[filterType];
+      report(name, n, timeCall([&]{ sink = runPipeline(data, syntheticBaseline(noiseLevel), filterType, 0); }), n);
+    }
+
+    //refreshing the analysis after a window of 100 intensities in the middle changes, which alternates between two values
+    configuration config;
+    config.baseline = syntheticBaseline(noiseLevel);
+    config.filterType = 1;
+    config.filterSize = 5;
+    config.numPasses = 1;
+    IncrementalAnalysis incremental(data, config);
+    std::vector<double> windows[2];
+    for(int i = n/2; i < n/2 + 100; i++)
+    {
+      windows[0].push_back(data[i].second);
+      windows[1].push_back(1.01*data[i].second);
+    }
+    int calls = 0;
+    report("incremental update, boxcar", n, timeCall([&]{
+      incremental.update(n/2, windows[calls++ % 2]);
+      sink = incremental.getPeaks().size();
+    }), n);
+  }
+  std::cout << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+  int maxPoints = argc > 1 ? std::stoi(argv[1]) : 10000000;
+  int numPeaks = argc > 2 ? std::stoi(argv[2]) : 20;
+  double noiseLevel = argc > 3 ? std::stod(argv[3]) : 10.0;
+
+  benchKernels(numPeaks, noiseLevel);
+  benchPipeline(maxPoints, numPeaks, noiseLevel);
+  return 0;
+}
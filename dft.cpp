@@ -1,42 +1,34 @@
-#include <armadillo>
+#include "numeric.h"
 #include <vector>
 #include <complex>
+#include <cmath>
 
-arma::cx_mat makeZ(int n)
+//the diagonal of G, the gaussian filter applied to the Fourier coefficients of the data
+//the Kronecker delta function in the formula for the elements of G makes it so
+//that only the diagonal of G is nonzero
+std::vector<double> makeG(int n)
 {
-  arma::cx_mat Z(n, n); //Z is an nxn matrix
-  for(int j = 0; j<n; j++)
-  {
-    for(int k = 0; k<n; k++)
-    {
-      Z(j,k) = std::pow(std::polar(1.0, -2*M_PI/n), j*k) / sqrt(n);
-    }
-  }
-  return Z;
-}
-
-arma::cx_mat makeG(int n)
-{
-  //G is an nxn matrix initialized to all zeros
-  arma::cx_mat G(n,n, arma::fill::zeros);
-  //the Kronecker delta function in formula for the elements of G makes it so
-  //that only the diagonal of G is nonzero
+  std::vector<double> G(n);
   for(int i = 0; i<n; i++)
   {
-    G(i,i) = exp((-4*M_LN2*i*i) / pow(n, 1.5));
+    G[i] = exp((-4*M_LN2*i*i) / pow(n, 1.5));
   }
   return G;
 }
 
-//applies the Discrete Fourier Transform Filter to an arma::cx_vec
-arma::cx_vec dftFilter(const arma::cx_vec& y)
+//applies the Discrete Fourier Transform Filter, conj(Z)*G*Z*y, to y
+//Z is the unitary DFT matrix, so instead of building it Z*y is found with the FFT and scaled by 1/sqrt(n),
+//and so is multiplying by conj(Z), which is the inverse transform
+void dftFilter(std::vector<std::complex<double>>& y)
 {
   int n = y.size(); //n is the dimension of y
-  arma::cx_mat Z = makeZ(n);
-  arma::cx_vec c = Z*y;
-  arma::cx_mat G = makeG(n);
-  c = G*c;
-  return conj(Z)*c;
+  fft(y, false);
+  std::vector<double> G = makeG(n);
+  for(int i = 0; i<n; i++)
+  {
+    y[i] *= G[i] / n; //both transforms scale by 1/sqrt(n)
+  }
+  fft(y, true);
 }
 
 
@@ -44,14 +36,14 @@ arma::cx_vec dftFilter(const arma::cx_vec& y)
 std::vector<std::pair<double, double>> dftFilter(std::vector<std::pair<double, double>> data)
 {
   int n = data.size();
-  //put all the y-values of the elements in data into an armadillo vector
-  arma::cx_vec y(n);
+  //put all the y-values of the elements in data into a complex vector
+  std::vector<std::complex<double>> y(n);
   for (int i = 0; i < n; i++)
   {
     y[i] = data[i].second;
   }
 
-  y = dftFilter(y);
+  dftFilter(y);
 
   //put all the filtered y values back into the std::vector data
   for (int i = 0; i < n; i++)
@@ -1,56 +1,103 @@
 //functions for filtering the data
 #include <vector>
 #include <utility>
+#include <string>
+#include <memory_resource>
 #include "prototypes.h"
+#include "arena.h"
 
-//applies a boxcar filter to data
-std::vector<std::pair<double, double>> boxcarFilter(std::vector<std::pair<double, double>> data, int filterSize)
+//copies the intensities of data into a buffer of type T
+//filtering only needs the intensities, so the x-values are left where they are
+//the buffer comes from the scratch arena, since it only lives as long as the filter
+template <typename T>
+std::pmr::vector<T> intensities(const std::vector<std::pair<double, double>>& data)
 {
-  int n = data.size();
-  std::vector<std::pair<double, double>> result;
-  result.reserve(n);
+  std::pmr::vector<T> y(data.size(), scratch());
+  for(int i = 0; i < y.size(); i++)
+    y[i] = data[i].second;
+  return y;
+}
+
+//applies a boxcar filter to y, wrapping around at its ends, and stores the result in result
+template <typename T>
+void boxcarFilter(const std::pmr::vector<T>& y, std::pmr::vector<T>& result, int filterSize)
+{
+  int n = y.size();
+  int half = (filterSize-1)/2;
+  T size = filterSize;
   for(int i = 0; i < n; i++)
   {
-    int startIndex = i - (filterSize-1)/2;
-    int endIndex = i + (filterSize-1)/2;
-    double sum = 0;
-    std::vector<double> boxcar;
-    for(int j = startIndex; j <= endIndex; j++)
+    T sum = 0;
+    //only the points near the ends need to wrap around
+    if(i >= half && i+half < n)
     {
-      sum += data[(j+n)%n].second / filterSize;
+      for(int j = i-half; j <= i+half; j++)
+        sum += y[j] / size;
     }
-    result.push_back({data[i].first, sum});
+    else
+    {
+      for(int j = i-half; j <= i+half; j++)
+        sum += y[(j+n)%n] / size;
+    }
+    result[i] = sum;
   }
-  return result;
 }
 
-//applies a boxcar filter to data for multiple passes
+//applies a boxcar filter to data for multiple passes, with the intensities stored as T in between them
+template <typename T>
 std::vector<std::pair<double, double>> boxcarFilter(std::vector<std::pair<double, double>> data, int filterSize, int numPasses)
 {
-  if(filterSize >= data.size())
-  {
-    std::cerr << "Error: number of filter points must be less than the number of data points" << std::endl;
-    exit(1);
-  }
-
+  std::pmr::vector<T> y = intensities<T>(data);
+  std::pmr::vector<T> result(y.size(), scratch());
   for(int i = 0; i < numPasses; i++)
   {
-    data = boxcarFilter(data, filterSize);
+    boxcarFilter(y, result, filterSize);
+    std::swap(y, result);
   }
 
+  for(int i = 0; i < data.size(); i++)
+    data[i].second = y[i];
   return data;
 }
 
+//applies a boxcar filter to data for multiple passes
+//precision 1 filters the intensities in single precision
+std::vector<std::pair<double, double>> boxcarFilter(std::vector<std::pair<double, double>> data, int filterSize, int numPasses, int precision)
+{
+  if(filterSize >= data.size())
+    throw nmrException{NMR_INVALID_DATA, "number of filter points must be less than the number of data points"};
 
-//applies a Savitzky-Golay filter to the data
-//filterSize must be 5, 11, or 17
-std::vector<std::pair<double, double>> savitzkyGolayFilter(std::vector<std::pair<double, double>> data, int filterSize)
+  if(precision == 1)
+    return boxcarFilter<float>(std::move(data), filterSize, numPasses);
+  return boxcarFilter<double>(std::move(data), filterSize, numPasses);
+}
+
+
+//applies a Savitzky-Golay filter to y and stores the result in result
+//the filter can't be applied to the first and last 1+filterSize/2 points, so they are left out of the result
+template <typename T>
+void savitzkyGolayFilter(const std::pmr::vector<T>& y, std::pmr::vector<T>& result, const std::vector<T>& coefficients, int norm)
 {
-  int n = data.size();
-  std::vector<std::pair<double, double>> result;
-  result.reserve(n);
+  int n = y.size();
+  int filterSize = coefficients.size();
+  result.clear();
+  for(int i = 1+filterSize/2; i < n-1-filterSize/2; i++)
+  {
+    T sum = 0;
+    for(int j = 0; j < filterSize; j++)
+    {
+      sum += coefficients[j] * y[i+j-filterSize/2];
+    }
+    result.push_back(sum/norm);
+  }
+}
 
-  std::vector<int> coefficients;   //the convoluting coefficients
+//applies a Savitzky-Golay filter to data for multiple passes, with the intensities stored as T in between them
+//filterSize must be 5, 11, or 17
+template <typename T>
+std::vector<std::pair<double, double>> savitzkyGolayFilter(std::vector<std::pair<double, double>> data, int filterSize, int numPasses)
+{
+  std::vector<T> coefficients;   //the convoluting coefficients
   int norm; //the normalizing factor
 
   //these values are from Table 1 of the 1964 Savitzky-Golay paper
@@ -70,55 +117,61 @@ std::vector<std::pair<double, double>> savitzkyGolayFilter(std::vector<std::pair
       break;
   }
 
-  for(int i = 1+filterSize/2; i < n-1-filterSize/2; i++)
+  std::pmr::vector<T> y = intensities<T>(data);
+  std::pmr::vector<T> result(scratch());
+  result.reserve(y.size());
+  //each pass drops points from both ends, so this is how far the first remaining point is from the start of data
+  int offset = 0;
+  for(int i = 0; i < numPasses; i++)
   {
-    double sum = 0;
-    for(int j = 0; j < filterSize; j++)
-    {
-      sum += coefficients[j] * data[i+j-filterSize/2].second;
-    }
-    result.push_back({data[i].first, sum/norm});
+    savitzkyGolayFilter(y, result, coefficients, norm);
+    std::swap(y, result);
+    if(!y.empty())
+      offset += 1+filterSize/2;
   }
-  return result;
+
+  std::vector<std::pair<double, double>> filtered;
+  filtered.reserve(y.size());
+  for(int i = 0; i < y.size(); i++)
+    filtered.push_back({data[i+offset].first, y[i]});
+  return filtered;
 }
 
 //applies a Savitzky-Golay filter to data for multiple passes
-std::vector<std::pair<double, double>> savitzkyGolayFilter(std::vector<std::pair<double, double>> data, int filterSize, int numPasses)
+//precision 1 filters the intensities in single precision
+std::vector<std::pair<double, double>> savitzkyGolayFilter(std::vector<std::pair<double, double>> data, int filterSize, int numPasses, int precision)
 {
+  //each pass drops 1+filterSize/2 points from both ends, and the spline needs at least 3 of them to be left
+  if(numPasses > 0 && int(data.size()) - 2*numPasses*(1+filterSize/2) < 3)
+    throw nmrException{NMR_INVALID_DATA, "the spectrum is too short for " + std::to_string(numPasses) + " passes of a Savitzky-Golay filter of size " + std::to_string(filterSize)};
   if(filterSize != 5 && filterSize != 11 && filterSize != 17)
-  {
-    std::cerr << "Error: Savitzky-Golay filter must have a size of 5, 11, or 17." << std::endl;
-    exit(1);
-  }
+    throw nmrException{NMR_INVALID_OPTION, "Savitzky-Golay filter must have a size of 5, 11, or 17."};
 
-  for(int i = 0; i < numPasses; i++)
-    data = savitzkyGolayFilter(data, filterSize);
-
-  return data;
+  if(precision == 1)
+    return savitzkyGolayFilter<float>(std::move(data), filterSize, numPasses);
+  return savitzkyGolayFilter<double>(std::move(data), filterSize, numPasses);
 }
 
 //filters the data according to the options specified
-std::vector<std::pair<double, double>> filter(std::vector<std::pair<double, double>> data, int filterType, int filterSize, int numPasses)
+//the intensities are filtered in double precision, or in single precision if precision is 1
+//the DFT filter always works in double precision, since rounding error in the FFT grows with the number of points
+std::vector<std::pair<double, double>> filter(std::vector<std::pair<double, double>> data, int filterType, int filterSize, int numPasses, int precision)
 {
 
   if(filterType != 0 && filterType != 3 && filterSize % 2 == 0)
-  {
-    std::cerr << "Error: filter size must be odd." << std::endl;
-    exit(1);
-  }
+    throw nmrException{NMR_INVALID_OPTION, "filter size must be odd."};
 
   switch (filterType)
   {
     case 0: //no filter
       return data;
     case 1: //boxcar
-      return boxcarFilter(data, filterSize, numPasses);
+      return boxcarFilter(std::move(data), filterSize, numPasses, precision);
     case 2: //Savitzky-Golay
-      return savitzkyGolayFilter(data, filterSize, numPasses);
+      return savitzkyGolayFilter(std::move(data), filterSize, numPasses, precision);
     case 3: //Discrete Fourier Transform filter
       return dftFilter(data);
     default:
-      std::cerr << "Error: filter type " << filterType << " is not valid." << std::endl;
-      exit(1);
+      throw nmrException{NMR_INVALID_OPTION, "filter type " + std::to_string(filterType) + " is not valid."};
   }
 }
@@ -0,0 +1,347 @@
+//functions to fit line shapes to the peaks
+//each peak region is fitted with a sum of Lorentzian, Gaussian or pseudo-Voigt lines using the Levenberg-Marquardt method
+//this separates the lines of overlapping multiplets and gives a better location for asymmetric peaks
+#include "structs.h"
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <atomic>
+
+//most lines fitted to a single peak region
+#define MAX_LINES 8
+//local maxima smaller than this fraction of the tallest point in a region are treated as noise, not as lines
+#define LINE_THRESHOLD 0.05
+#define MAX_FIT_ITERATIONS 100
+//the fit stops once an iteration improves the sum of squared residuals by less than this fraction
+#define FIT_TOLERANCE 1e-10
+//widths are kept above this many ppm so a line can't collapse onto a single point
+#define MIN_WIDTH 1e-6
+
+//the height of a Gaussian with unit height is 1/2 at u = +-1
+#define GAUSSIAN_SCALE M_LN2
+
+//value of the line shape at x and its derivatives with respect to the line's parameters
+struct lineValue
+{
+  double value, dCenter, dHeight, dWidth, dEta;
+};
+
+//evaluates a line at x
+//Lorentzian lines have eta = 1, Gaussian lines have eta = 0 and pseudo-Voigt lines are a mix of the two
+lineValue evaluateLine(const lineShape& line, double x)
+{
+  double u = (x - line.center)/line.width;
+  double lorentz = 1/(1 + u*u);
+  double gauss = exp(-GAUSSIAN_SCALE*u*u);
+
+  //derivative of each shape with respect to u
+  double dLorentz = -2*u*lorentz*lorentz;
+  double dGauss = -2*GAUSSIAN_SCALE*u*gauss;
+
+  double shape = line.eta*lorentz + (1-line.eta)*gauss;
+  double dShape = line.eta*dLorentz + (1-line.eta)*dGauss;
+
+  lineValue result;
+  result.value = line.height*shape;
+  result.dHeight = shape;
+  result.dCenter = -line.height*dShape/line.width; //du/dcenter = -1/width
+  result.dWidth = -line.height*dShape*u/line.width; //du/dwidth = -u/width
+  result.dEta = line.height*(lorentz - gauss);
+  return result;
+}
+
+//area under a line from -infinity to infinity
+double lineArea(const lineShape& line)
+{
+  double lorentzArea = M_PI*line.height*line.width;
+  double gaussArea = line.height*line.width*sqrt(M_PI/GAUSSIAN_SCALE);
+  return line.eta*lorentzArea + (1-line.eta)*gaussArea;
+}
+
+//solves the nxn system A*x = b with Gaussian elimination and partial pivoting
+//A is stored row by row; returns false if A is singular
+bool solveLinearSystem(std::vector<double> A, std::vector<double> b, int n, std::vector<double>& x)
+{
+  for(int k = 0; k < n; k++)
+  {
+    int pivot = k;
+    for(int i = k+1; i < n; i++)
+      if(fabs(A[i*n+k]) > fabs(A[pivot*n+k]))
+        pivot = i;
+    if(A[pivot*n+k] == 0)
+      return false;
+    if(pivot != k)
+    {
+      for(int j = 0; j < n; j++)
+        std::swap(A[k*n+j], A[pivot*n+j]);
+      std::swap(b[k], b[pivot]);
+    }
+    for(int i = k+1; i < n; i++)
+    {
+      double factor = A[i*n+k]/A[k*n+k];
+      for(int j = k; j < n; j++)
+        A[i*n+j] -= factor*A[k*n+j];
+      b[i] -= factor*b[k];
+    }
+  }
+
+  x.assign(n, 0);
+  for(int i = n-1; i >= 0; i--)
+  {
+    double sum = b[i];
+    for(int j = i+1; j < n; j++)
+      sum -= A[i*n+j]*x[j];
+    x[i] = sum/A[i*n+i];
+  }
+  return true;
+}
+
+//how many parameters each line has in the fit
+//eta is only fitted for pseudo-Voigt lines
+int parametersPerLine(int peakModel)
+{
+  return peakModel == 3 ? 4 : 3;
+}
+
+//reads the lines out of a vector of fit parameters
+//every line is kept inside the peak region [begin,end], no wider than the region and no lower than the baseline
+std::vector<lineShape> unpackLines(const std::vector<double>& parameters, int peakModel, double eta, double begin, double end)
+{
+  int perLine = parametersPerLine(peakModel);
+  std::vector<lineShape> lines(parameters.size()/perLine);
+  for(int i = 0; i < lines.size(); i++)
+  {
+    lines[i].center = std::min(end, std::max(begin, parameters[i*perLine]));
+    lines[i].height = std::max(0.0, parameters[i*perLine+1]);
+    lines[i].width = std::min(end - begin, std::max(MIN_WIDTH, parameters[i*perLine+2]));
+    lines[i].eta = perLine == 4 ? std::min(1.0, std::max(0.0, parameters[i*perLine+3])) : eta;
+  }
+  return lines;
+}
+
+//sum of squared residuals of the lines on the points (xs, ys)
+double fitCost(const std::vector<lineShape>& lines, const std::vector<double>& xs, const std::vector<double>& ys)
+{
+  double cost = 0;
+  for(int k = 0; k < xs.size(); k++)
+  {
+    double residual = ys[k];
+    for(auto & line : lines)
+      residual -= evaluateLine(line, xs[k]).value;
+    cost += residual*residual;
+  }
+  return cost;
+}
+
+//fits a sum of lines to the points (xs, ys) of the peak region [begin,end], starting from the guesses in lines
+//returns the fitted lines
+std::vector<lineShape> levenbergMarquardt(std::vector<lineShape> lines, const std::vector<double>& xs, const std::vector<double>& ys, int peakModel, double begin, double end)
+{
+  int perLine = parametersPerLine(peakModel);
+  int n = perLine*lines.size(); //number of parameters
+  int m = xs.size(); //number of points
+  double eta = lines.front().eta;
+
+  std::vector<double> parameters(n);
+  for(int i = 0; i < lines.size(); i++)
+  {
+    parameters[i*perLine] = lines[i].center;
+    parameters[i*perLine+1] = lines[i].height;
+    parameters[i*perLine+2] = lines[i].width;
+    if(perLine == 4)
+      parameters[i*perLine+3] = lines[i].eta;
+  }
+
+  double lambda = 1e-3;
+  double cost = fitCost(lines, xs, ys);
+  std::vector<double> jacobian(m*n), residuals(m);
+  std::vector<double> JTJ(n*n), JTr(n), step;
+  for(int iteration = 0; iteration < MAX_FIT_ITERATIONS; iteration++)
+  {
+    //residuals and the analytic Jacobian
+    //the Jacobian is stored column by column so every loop over the points runs over contiguous memory
+    for(int k = 0; k < m; k++)
+      residuals[k] = ys[k];
+    for(int i = 0; i < lines.size(); i++)
+    {
+      double* dCenter = &jacobian[(i*perLine)*m];
+      double* dHeight = &jacobian[(i*perLine+1)*m];
+      double* dWidth = &jacobian[(i*perLine+2)*m];
+      double* dEta = perLine == 4 ? &jacobian[(i*perLine+3)*m] : nullptr;
+      for(int k = 0; k < m; k++)
+      {
+        lineValue v = evaluateLine(lines[i], xs[k]);
+        residuals[k] -= v.value;
+        dCenter[k] = v.dCenter;
+        dHeight[k] = v.dHeight;
+        dWidth[k] = v.dWidth;
+        if(dEta)
+          dEta[k] = v.dEta;
+      }
+    }
+
+    //normal equations J^T*J*step = J^T*r
+    for(int i = 0; i < n; i++)
+    {
+      const double* column = &jacobian[i*m];
+      double sum = 0;
+      for(int k = 0; k < m; k++)
+        sum += column[k]*residuals[k];
+      JTr[i] = sum;
+      for(int j = 0; j <= i; j++)
+      {
+        const double* other = &jacobian[j*m];
+        double dot = 0;
+        for(int k = 0; k < m; k++)
+          dot += column[k]*other[k];
+        JTJ[i*n+j] = dot;
+        JTJ[j*n+i] = dot;
+      }
+    }
+
+    //increase the damping until a step lowers the cost
+    bool improved = false;
+    double newCost = cost;
+    while(!improved && lambda < 1e10)
+    {
+      std::vector<double> damped = JTJ;
+      for(int i = 0; i < n; i++)
+        damped[i*n+i] += lambda*std::max(JTJ[i*n+i], 1e-12);
+      if(!solveLinearSystem(damped, JTr, n, step))
+      {
+        lambda *= 10;
+        continue;
+      }
+
+      std::vector<double> trial = parameters;
+      for(int i = 0; i < n; i++)
+        trial[i] += step[i];
+      std::vector<lineShape> trialLines = unpackLines(trial, peakModel, eta, begin, end);
+      newCost = fitCost(trialLines, xs, ys);
+      if(newCost < cost)
+      {
+        improved = true;
+        lines = trialLines;
+        //keep the parameters inside the limits unpackLines applies
+        parameters = trial;
+        for(int i = 0; i < lines.size(); i++)
+        {
+          parameters[i*perLine] = lines[i].center;
+          parameters[i*perLine+1] = lines[i].height;
+          parameters[i*perLine+2] = lines[i].width;
+          if(perLine == 4)
+            parameters[i*perLine+3] = lines[i].eta;
+        }
+        lambda = std::max(lambda/10, 1e-12);
+      }
+      else
+        lambda *= 10;
+    }
+
+    if(!improved || cost - newCost <= FIT_TOLERANCE*cost)
+      break;
+    cost = newCost;
+  }
+  return lines;
+}
+
+//makes the initial guesses for the lines in a peak region from its local maxima
+//the width of each guess is where the points first drop below half of its height
+std::vector<lineShape> guessLines(const std::vector<double>& xs, const std::vector<double>& ys, double eta)
+{
+  int m = xs.size();
+  double tallest = *std::max_element(ys.begin(), ys.end());
+
+  std::vector<int> maxima;
+  for(int k = 0; k < m; k++)
+  {
+    bool aboveLeft = k == 0 || ys[k] > ys[k-1];
+    bool aboveRight = k == m-1 || ys[k] >= ys[k+1];
+    if(aboveLeft && aboveRight && ys[k] >= LINE_THRESHOLD*tallest)
+      maxima.push_back(k);
+  }
+  //keep the tallest maxima
+  std::sort(maxima.begin(), maxima.end(), [&](int a, int b){ return ys[a] > ys[b]; });
+  if(maxima.size() > MAX_LINES)
+    maxima.resize(MAX_LINES);
+
+  std::vector<lineShape> lines;
+  for(int k : maxima)
+  {
+    int left = k, right = k;
+    while(left > 0 && ys[left] > ys[k]/2)
+      left--;
+    while(right < m-1 && ys[right] > ys[k]/2)
+      right++;
+    double width = std::max(MIN_WIDTH, fabs(xs[right] - xs[left])/2);
+    lines.push_back({xs[k], ys[k], width, eta});
+  }
+  return lines;
+}
+
+//fits lines to one peak region and moves its location to the area weighted center of the lines
+//data must be sorted from most positive to most negative x
+void fitPeak(peak& p, const std::vector<std::pair<double, double>>& data, int peakModel)
+{
+  //the points inside the region are found by binary search, so fitting a peak doesn't depend on the length of the spectrum
+  auto first = std::lower_bound(data.begin(), data.end(), p.end, [](const std::pair<double, double>& point, double x){ return point.first > x; });
+  std::vector<double> xs, ys;
+  for(auto point = first; point != data.end() && point->first >= p.begin; ++point)
+  {
+    xs.push_back(point->first);
+    ys.push_back(point->second);
+  }
+  //not enough points to fit even one line
+  if(xs.size() < parametersPerLine(peakModel))
+    return;
+
+  double eta = peakModel == 2 ? 0.0 : peakModel == 3 ? 0.5 : 1.0;
+  std::vector<lineShape> lines = guessLines(xs, ys, eta);
+  //a fit needs at least as many points as parameters
+  while(lines.size()*parametersPerLine(peakModel) > xs.size())
+    lines.pop_back();
+  if(lines.empty())
+    return;
+
+  p.lines = levenbergMarquardt(lines, xs, ys, peakModel, p.begin, p.end);
+  //lines the fit flattened onto the baseline aren't part of the peak
+  p.lines.erase(std::remove_if(p.lines.begin(), p.lines.end(), [](const lineShape& line){ return line.height <= 0; }), p.lines.end());
+
+  double weightedSum = 0, totalArea = 0;
+  for(auto & line : p.lines)
+  {
+    double area = lineArea(line);
+    weightedSum += area*line.center;
+    totalArea += area;
+  }
+  if(totalArea > 0 && p.begin <= weightedSum/totalArea && weightedSum/totalArea <= p.end)
+    p.location = weightedSum/totalArea;
+}
+
+//fits line shapes to every peak according to peakModel (0=none, 1=Lorentzian, 2=Gaussian, 3=pseudo-Voigt)
+//the regions are independent, so they are split between numThreads threads, 0 uses one per core
+std::vector<peak> fitPeaks(std::vector<peak> peaks, const std::vector<std::pair<double, double>>& data, int peakModel, int numThreads)
+{
+  if(peakModel == 0 || peaks.empty())
+    return peaks;
+
+  if(numThreads <= 0)
+    numThreads = std::thread::hardware_concurrency();
+  numThreads = std::max(1, std::min<int>(numThreads, peaks.size()));
+  std::atomic<int> next(0);
+  auto worker = [&]()
+  {
+    for(int i = next++; i < peaks.size(); i = next++)
+      fitPeak(peaks[i], data, peakModel);
+  };
+
+  std::vector<std::thread> threads;
+  for(int t = 1; t < numThreads; t++)
+    threads.emplace_back(worker);
+  worker();
+  for(auto & thread : threads)
+    thread.join();
+  return peaks;
+}
@@ -0,0 +1,100 @@
+//Gauss-Legendre quadrature rules generated at compile time
+//the n point rule integrates polynomials up to degree 2n-1 exactly on [-1,1]
+#pragma once
+#include <array>
+#include <utility>
+
+//the highest order that can be chosen at runtime
+//every order up to this one is generated when the program is compiled
+#define MAX_LEGENDRE_ORDER 64
+//higher orders are generated at runtime the first time they are used, up to this one
+#define MAX_QUADRATURE_ORDER 1024
+
+#define LEGENDRE_PI 3.14159265358979323846
+//Newton's method stops after this many steps, or once a step is smaller than LEGENDRE_TOLERANCE
+#define LEGENDRE_ITERATIONS 100
+#define LEGENDRE_TOLERANCE 1e-16
+
+//cosine of x for 0 <= x <= pi, from its Taylor series
+//std::cos isn't constexpr, and this is only used for the starting guesses of Newton's method
+constexpr double constexprCos(double x)
+{
+  double term = 1, sum = 1;
+  for(int k = 1; k < 40; k++)
+  {
+    term *= -x*x/((2*k-1)*(2*k));
+    sum += term;
+  }
+  return sum;
+}
+
+//evaluates the nth Legendre polynomial at x with its three term recurrence
+//derivative is set to the derivative of the polynomial at x
+constexpr double legendre(int n, double x, double& derivative)
+{
+  double p = 1, previous = 0;
+  for(int k = 1; k <= n; k++)
+  {
+    double next = ((2*k-1)*x*p - (k-1)*previous)/k;
+    previous = p;
+    p = next;
+  }
+  derivative = n*(x*p - previous)/(x*x - 1);
+  return p;
+}
+
+//the nodes and weights of the N point rule, with the nodes in ascending order
+template <int N>
+struct legendreRule
+{
+  std::array<double, N> nodes, weights;
+};
+
+//finds the roots of the Nth Legendre polynomial with Newton's method and the weight of each one
+//the rule is symmetric, so only the negative half is solved for and the rest is mirrored
+template <int N>
+constexpr legendreRule<N> makeLegendreRule()
+{
+  legendreRule<N> rule{};
+  for(int i = 0; i < (N+1)/2; i++)
+  {
+    //a close approximation of the ith largest root
+    double x = constexprCos(LEGENDRE_PI*(i + 0.75)/(N + 0.5));
+    double derivative = 0;
+    for(int iteration = 0; iteration < LEGENDRE_ITERATIONS; iteration++)
+    {
+      double step = legendre(N, x, derivative)/derivative;
+      x -= step;
+      if(step < LEGENDRE_TOLERANCE && -step < LEGENDRE_TOLERANCE)
+        break;
+    }
+    legendre(N, x, derivative);
+    double weight = 2/((1 - x*x)*derivative*derivative);
+    rule.nodes[i] = -x;
+    rule.nodes[N-1-i] = x;
+    rule.weights[i] = weight;
+    rule.weights[N-1-i] = weight;
+  }
+  //the middle node of an odd rule is exactly 0
+  if(N%2 == 1)
+    rule.nodes[N/2] = 0;
+  return rule;
+}
+
+template <int N>
+constexpr legendreRule<N> legendreTable = makeLegendreRule<N>();
+
+//points nodes and weights at the compile time table for the n point rule
+//returns false if n isn't between 1 and MAX_LEGENDRE_ORDER
+template <int... Ns>
+bool findLegendreRule(int n, const double*& nodes, const double*& weights, std::integer_sequence<int, Ns...>)
+{
+  bool found = false;
+  ((n == Ns+1 ? (nodes = legendreTable<Ns+1>.nodes.data(), weights = legendreTable<Ns+1>.weights.data(), found = true) : false), ...);
+  return found;
+}
+
+inline bool findLegendreRule(int n, const double*& nodes, const double*& weights)
+{
+  return findLegendreRule(n, nodes, weights, std::make_integer_sequence<int, MAX_LEGENDRE_ORDER>());
+}
@@ -1,83 +1,151 @@
-//functions for graphing the cubic spline with gnuplot
+//functions for graphing the cubic spline as an SVG image
 //used for debugging
+//everything is rendered in-process and written straight to fileName, so it is safe to call from multiple threads
 #include "CubicSpline.h"
 #include "structs.h"
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <vector>
 #include <limits>
+#include <cmath>
+#include <algorithm>
 
-int count = 1;
+//size of the image and the margin around the plot area, in pixels
+#define GRAPH_WIDTH 1200
+#define GRAPH_HEIGHT 700
+#define GRAPH_MARGIN 60
+//how many points the spline is sampled at
+#define GRAPH_SAMPLES 10000
+//how many labelled ticks are drawn on each axis
+#define GRAPH_TICKS 10
 
-std::string gnuPrint(Polynomial p)
+//maps data coordinates to pixel coordinates
+//x is drawn from most positive on the left to most negative on the right, as is usual for nmr spectra
+struct plotArea
 {
-  std::stringstream result;
-  result.precision(std::numeric_limits<double>::max_digits10);
-  int n = p.getDegree();
-  for (int i =0; i <= n; i++)
-  {
-    if(p[i] == 0)
-      continue;
+  double minX, maxX, minY, maxY;
 
-    result << p[i];
-    if (i != 0)
-      result << "*x";
+  double pixelX(double x) const
+  {
+    return GRAPH_MARGIN + (maxX - x)/(maxX - minX)*(GRAPH_WIDTH - 2*GRAPH_MARGIN);
+  }
 
-    if(i > 1)
-      result << "**" << i;
+  double pixelY(double y) const
+  {
+    return GRAPH_HEIGHT - GRAPH_MARGIN - (y - minY)/(maxY - minY)*(GRAPH_HEIGHT - 2*GRAPH_MARGIN);
+  }
+};
 
-    if(i < n)
-      result << " + ";
+//finds the range of the data, padded so nothing is drawn right on the edge
+plotArea makePlotArea(const std::vector<std::pair<double,double>>& points)
+{
+  plotArea area = {std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity(), 0, 0};
+  for(auto & point : points)
+  {
+    area.minX = std::min(area.minX, point.first);
+    area.maxX = std::max(area.maxX, point.first);
+    area.minY = std::min(area.minY, point.second);
+    area.maxY = std::max(area.maxY, point.second);
   }
-  return result.str();
+  double padding = 0.05*(area.maxY - area.minY);
+  area.minY -= padding;
+  area.maxY += padding;
+  if(area.minX == area.maxX)
+    area.maxX = area.minX + 1;
+  if(area.minY == area.maxY)
+    area.maxY = area.minY + 1;
+  return area;
 }
 
-//returns a string representing a cubic spline
-std::string gnuPrint(CubicSpline c)
+//draws the frame, the tick labels and the baseline
+void drawAxes(std::ostream& svg, const plotArea& area)
 {
-  std::stringstream result;
-  for(int i = 0; i < c.cubics.size()-1; i++)
+  svg << "<rect x='" << GRAPH_MARGIN << "' y='" << GRAPH_MARGIN << "' width='" << GRAPH_WIDTH - 2*GRAPH_MARGIN
+      << "' height='" << GRAPH_HEIGHT - 2*GRAPH_MARGIN << "' fill='none' stroke='black'/>\n";
+  for(int i = 0; i <= GRAPH_TICKS; i++)
   {
-    result << "x<" << c.xValues[i+1] << " ? " << gnuPrint(c.cubics[i]) << " : ";
+    double x = area.maxX - i*(area.maxX - area.minX)/GRAPH_TICKS;
+    double y = area.minY + i*(area.maxY - area.minY)/GRAPH_TICKS;
+    svg << "<text x='" << area.pixelX(x) << "' y='" << GRAPH_HEIGHT - GRAPH_MARGIN + 20 << "' font-size='12' text-anchor='middle'>" << x << "</text>\n";
+    svg << "<text x='" << GRAPH_MARGIN - 5 << "' y='" << area.pixelY(y) + 4 << "' font-size='12' text-anchor='end'>" << y << "</text>\n";
   }
-  result << gnuPrint(c.cubics.back());
-
-  return result.str();
+  svg << "<line x1='" << GRAPH_MARGIN << "' y1='" << area.pixelY(0) << "' x2='" << GRAPH_WIDTH - GRAPH_MARGIN << "' y2='" << area.pixelY(0)
+      << "' stroke='green' stroke-dasharray='6,4'><title>Baseline</title></line>\n";
 }
 
-void graph(std::vector<std::pair<double,double>> points)
+//draws every point as a small dot
+void drawPoints(std::ostream& svg, const plotArea& area, const std::vector<std::pair<double,double>>& points)
 {
-  std::ofstream script("tmp.plt");
-
-  script  << "set terminal pngcairo\n"
-          << "set output 'graph" << count++ << ".png'\n"
-          << "set samples 10000\n"
-          << "plot 0 title 'Baseline', '-' notitle\n";
+  svg << "<g fill='black'>\n";
+  for(auto & point : points)
+    svg << "<circle cx='" << area.pixelX(point.first) << "' cy='" << area.pixelY(point.second) << "' r='1.5'/>\n";
+  svg << "</g>\n";
+}
 
-  for(auto & point: points)
+//shades the region of each peak and labels it with its number
+void drawPeaks(std::ostream& svg, const plotArea& area, const std::vector<peak>& peaks)
+{
+  for(int i = 0; i < peaks.size(); i++)
   {
-    script << point.first << '\t' <<point.second << std::endl;
+    double left = area.pixelX(peaks[i].begin);
+    double right = area.pixelX(peaks[i].end);
+    svg << "<rect x='" << std::min(left, right) << "' y='" << GRAPH_MARGIN << "' width='" << fabs(right - left)
+        << "' height='" << GRAPH_HEIGHT - 2*GRAPH_MARGIN << "' fill='orange' fill-opacity='0.3'/>\n";
+    svg << "<text x='" << area.pixelX(peaks[i].location) << "' y='" << GRAPH_MARGIN - 8 << "' font-size='12' text-anchor='middle'>" << i+1 << "</text>\n";
   }
+}
+
+//samples the spline evenly across the plot and draws it as one line
+void drawSpline(std::ostream& svg, const plotArea& area, const CubicSpline& spline)
+{
+  std::vector<double> xs(GRAPH_SAMPLES);
+  for(int i = 0; i < GRAPH_SAMPLES; i++)
+    xs[i] = area.minX + i*(area.maxX - area.minX)/(GRAPH_SAMPLES-1);
+  std::vector<double> ys = spline.evaluate(xs);
 
-  system("gnuplot tmp.plt");
-  system("rm tmp.plt");
+  svg << "<polyline fill='none' stroke='blue' points='";
+  for(int i = 0; i < GRAPH_SAMPLES; i++)
+    svg << area.pixelX(xs[i]) << ',' << area.pixelY(std::max(area.minY, std::min(area.maxY, ys[i]))) << ' ';
+  svg << "'><title>Spline</title></polyline>\n";
 }
 
-void graph(CubicSpline spline, std::vector<std::pair<double,double>> points)
+//renders the plot as an SVG document; spline and peaks are only drawn if they are given
+std::string renderGraph(const std::vector<std::pair<double,double>>& points, const CubicSpline* spline, const std::vector<peak>& peaks)
 {
-  std::ofstream script("tmp.plt");
+  plotArea area = makePlotArea(points);
 
-  script  << "set terminal pngcairo\n"
-          << "set output 'graph" << count++ << ".png'\n"
-          << "set samples 10000\n"
-          << "p(x) = " << gnuPrint(spline) << "\n"
-          << "plot p(x) title 'Spline', 0 title 'Baseline', '-' notitle\n";
+  std::stringstream svg;
+  svg.precision(6);
+  svg << "<svg xmlns='http://www.w3.org/2000/svg' width='" << GRAPH_WIDTH << "' height='" << GRAPH_HEIGHT << "'>\n";
+  svg << "<rect width='100%' height='100%' fill='white'/>\n";
+  drawPeaks(svg, area, peaks);
+  drawAxes(svg, area);
+  drawPoints(svg, area, points);
+  if(spline)
+    drawSpline(svg, area, *spline);
+  svg << "</svg>\n";
+  return svg.str();
+}
 
-  for(auto & point: points)
-  {
-    script << point.first << '\t' <<point.second << std::endl;
-  }
+//writes the plot to fileName
+void writeGraph(std::string fileName, const std::vector<std::pair<double,double>>& points, const CubicSpline* spline, const std::vector<peak>& peaks)
+{
+  std::ofstream file(fileName);
+  file << renderGraph(points, spline, peaks);
+}
 
-  system("gnuplot tmp.plt");
-  system("rm tmp.plt");
+void graph(std::vector<std::pair<double,double>> points, std::string fileName)
+{
+  writeGraph(fileName, points, nullptr, {});
+}
+
+void graph(CubicSpline spline, std::vector<std::pair<double,double>> points, std::string fileName)
+{
+  writeGraph(fileName, points, &spline, {});
+}
+
+void graph(CubicSpline spline, std::vector<std::pair<double,double>> points, std::vector<peak> peaks, std::string fileName)
+{
+  writeGraph(fileName, points, &spline, peaks);
 }
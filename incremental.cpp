@@ -0,0 +1,247 @@
+//implementation of incremental.h
+//an update changes a window of intensities, and its effect on every stage stays close to that window:
+//the boxcar and Savitzky-Golay filters only mix points within a few filter widths, the spline's coefficients
+//are solved again on a window around it, and only the regions between roots near it are integrated again
+//the noise that small peaks are measured against is kept sorted in a NoiseEstimate, so it is updated point by point too
+//the automatic baselines and the DFT filter depend on every point, so with them each update runs the whole analysis
+#include "incremental.h"
+#include "structs.h"
+#include "prototypes.h"
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <limits>
+
+IncrementalAnalysis::IncrementalAnalysis(std::vector<std::pair<double, double>> data, const configuration& config) : config(config)
+{
+  givenOrder = findOrder(data);
+  shift = 0;
+  if(!isLocal())
+  {
+    given = std::move(data);
+    peaks = analyze(given, config, shift);
+    return;
+  }
+
+  //the same stages as analyze, keeping the result of each one
+  spectrum ordered = orderSpectrum(std::move(data), -1, config.numThreads);
+  baselineAdjustment(ordered, config.baseline, config.baselineMode, shift);
+  adjusted = std::move(ordered.points);
+  tmsIndex = 0;
+  while(tmsIndex < adjusted.size() && adjusted[tmsIndex].second < 0)
+    tmsIndex++;
+  filtered = filter(adjusted, config.filterType, config.filterSize, config.numPasses, config.precision);
+  if(config.minSnr > 0)
+    noiseEstimate.emplace(filtered);
+  spline.emplace(spectrum{filtered, -1});
+  roots = findRoots(*spline);
+  for(int i = 0; i+1 < roots.size(); i += 2)
+  {
+    regions.push_back({roots[i], roots[i+1]});
+    if(config.minSnr > 0)
+      regions.back().height = regionHeight(roots[i], roots[i+1]);
+  }
+  refreshPeaks();
+}
+
+//the constant baseline and the boxcar and Savitzky-Golay filters are local, and the spectrum has to be in order
+//so an index into it is an index into the sorted points
+bool IncrementalAnalysis::isLocal() const
+{
+  return config.baselineMode == 0 && config.filterType != 3 && givenOrder != 0;
+}
+
+void IncrementalAnalysis::setFiltered(int i, double intensity)
+{
+  if(noiseEstimate)
+    noiseEstimate->replace(filtered[i].second, intensity);
+  filtered[i].second = intensity;
+}
+
+//filters a slice of adjusted wide enough that the filtered values of every point near first to last are exact,
+//and copies them into filtered
+//the boxcar filter wraps around at the ends of the spectrum, so near them the whole spectrum is filtered again
+std::pair<int, int> IncrementalAnalysis::refilter(int first, int last)
+{
+  int n = adjusted.size();
+  if(config.filterType == 0 || config.numPasses == 0)
+  {
+    for(int i = first; i <= last; i++)
+      setFiltered(i, adjusted[i].second);
+    return {first, last};
+  }
+
+  //how far a change spreads through all the passes, and how many points the Savitzky-Golay filter drops from each end
+  int reach = config.numPasses*(config.filterSize/2);
+  int lead = (n - int(filtered.size()))/2;
+  //the slice is wide enough that the points it drops or wraps around are outside what changed
+  int margin = reach + lead + config.filterSize;
+  int begin = first - reach - margin, end = last + reach + margin;
+  if(config.filterType == 1 && (begin < 0 || end >= n))
+  {
+    filtered = filter(adjusted, config.filterType, config.filterSize, config.numPasses, config.precision);
+    if(noiseEstimate)
+      noiseEstimate.emplace(filtered);
+    return {0, int(filtered.size())-1};
+  }
+  begin = std::max(begin, 0);
+  end = std::min(end, n-1);
+
+  std::vector<std::pair<double, double>> slice(adjusted.begin() + begin, adjusted.begin() + end + 1);
+  slice = filter(std::move(slice), config.filterType, config.filterSize, config.numPasses, config.precision);
+  //the ith point of the slice is the (begin+i)th point of filtered, since both dropped lead points from their start
+  //only the points more than reach from the ends of a boxcar filtered slice are exact
+  int from = config.filterType == 1 ? reach : 0;
+  int to = int(slice.size()) - 1 - from;
+  for(int i = from; i <= to; i++)
+    setFiltered(begin + i, slice[i].second);
+  return {begin + from, begin + to};
+}
+
+//the spline at the middle of the region or the tallest data point inside it, whichever is higher
+double IncrementalAnalysis::regionHeight(double begin, double end) const
+{
+  double height = spline->evaluate((begin + end)/2);
+  auto point = std::lower_bound(filtered.begin(), filtered.end(), end, [](const std::pair<double, double>& p, double x){ return p.first > x; });
+  for(; point != filtered.end() && point->first >= begin; ++point)
+    height = std::max(height, point->second);
+  return height;
+}
+
+//finds the peaks of every region that doesn't have them yet, then collects the peaks of the regions that are kept
+//this is what calculatePeaks, findApexes and fitPeaks do, one region at a time
+void IncrementalAnalysis::refreshPeaks()
+{
+  double noiseFloor = 0;
+  double noise = noiseEstimate ? noiseEstimate->estimate(noiseFloor) : 0;
+
+  std::vector<int> kept, fresh;
+  for(int r = 0; r < regions.size(); r++)
+  {
+    peakRegion& region = regions[r];
+    double snr = 0;
+    if(config.minSnr > 0)
+    {
+      snr = noise > 0 ? (region.height - noiseFloor)/noise : std::numeric_limits<double>::infinity();
+      if(snr < config.minSnr)
+        continue;
+      for(peak & p : region.peaks)
+        p.snr = snr;
+    }
+    kept.push_back(r);
+    if(region.done)
+      continue;
+
+    peak p;
+    p.begin = region.begin;
+    p.end = region.end;
+    p.location = (p.begin + p.end)/2;
+    p.snr = snr;
+    p.area = integrate(p.begin, p.end, *spline, config.integrationTechnique, config.tolerance, config.quadratureOrder, config.kronrodOrder);
+    region.peaks = findApexes({p}, *spline, config.peakDetection, config.integrationTechnique, config.tolerance, config.quadratureOrder, config.kronrodOrder);
+    region.done = true;
+    fresh.push_back(r);
+  }
+
+  //the new regions are fitted together, so fitPeaks can spread them over its threads
+  if(config.peakModel != 0 && !fresh.empty())
+  {
+    std::vector<peak> unfitted;
+    for(int r : fresh)
+      unfitted.insert(unfitted.end(), regions[r].peaks.begin(), regions[r].peaks.end());
+    std::vector<peak> fitted = fitPeaks(std::move(unfitted), filtered, config.peakModel, config.numThreads);
+    int next = 0;
+    for(int r : fresh)
+      for(peak & p : regions[r].peaks)
+        p = fitted[next++];
+  }
+
+  peaks.clear();
+  for(int r : kept)
+    peaks.insert(peaks.end(), regions[r].peaks.begin(), regions[r].peaks.end());
+  peaks = countHydrogens(peaks);
+  shiftPeaks(peaks, shift);
+}
+
+void IncrementalAnalysis::update(int first, const std::vector<double>& intensities)
+{
+  if(intensities.empty())
+    return;
+  int n = size();
+  if(!isLocal())
+  {
+    for(int k = 0; k < intensities.size(); k++)
+      given[first+k].second = intensities[k];
+    peaks = analyze(given, config, shift);
+    return;
+  }
+
+  //the points are stored from most positive to most negative x, which is backwards if they were given in ascending order
+  int begin = givenOrder == -1 ? first : n - first - int(intensities.size());
+  int end = begin + int(intensities.size()) - 1;
+  for(int k = 0; k < intensities.size(); k++)
+  {
+    int i = givenOrder == -1 ? first + k : n - 1 - (first + k);
+    adjusted[i].second = intensities[k] - config.baseline;
+  }
+
+  //every point before the TMS peak is below the baseline, so it can only have moved if a point at or before it changed
+  if(begin <= tmsIndex)
+  {
+    tmsIndex = begin;
+    while(tmsIndex < n && adjusted[tmsIndex].second < 0)
+      tmsIndex++;
+    shift = tmsIndex < n ? adjusted[tmsIndex].first : 0;
+  }
+
+  //the spline's points are in ascending order, the reverse of filtered
+  std::pair<int, int> changed = refilter(begin, end);
+  int m = filtered.size();
+  std::vector<double> values;
+  for(int i = changed.second; i >= changed.first; i--)
+    values.push_back(filtered[i].second);
+  std::pair<int, int> cubics = spline->setValues(m - 1 - changed.second, values);
+  double from = spline->getRange(cubics.first).first;
+  double to = spline->getRange(cubics.second).second;
+
+  //the refitted cubics only have roots in (from, to], so those are the only ones that can have moved
+  auto rootsBegin = std::upper_bound(roots.begin(), roots.end(), from);
+  auto rootsEnd = std::upper_bound(roots.begin(), roots.end(), to);
+  std::vector<double> found = findRoots(*spline, cubics.first, cubics.second);
+  rootsBegin = roots.erase(rootsBegin, rootsEnd);
+  roots.insert(rootsBegin, found.begin(), found.end());
+
+  //pair up the roots again, keeping every region whose ends didn't move and that is outside the refitted cubics
+  //a change in how many roots there are shifts the pairs after it, so those regions are found again too
+  std::vector<peakRegion> old = std::move(regions);
+  regions.clear();
+  int next = 0;
+  for(int i = 0; i+1 < roots.size(); i += 2)
+  {
+    peakRegion region{roots[i], roots[i+1]};
+    while(next < old.size() && old[next].begin < region.begin)
+      next++;
+    bool untouched = region.end < from || region.begin > to;
+    if(untouched && next < old.size() && old[next].begin == region.begin && old[next].end == region.end)
+      region = std::move(old[next]);
+    else if(config.minSnr > 0)
+      region.height = regionHeight(region.begin, region.end);
+    regions.push_back(std::move(region));
+  }
+  refreshPeaks();
+}
+
+int IncrementalAnalysis::size() const
+{
+  return isLocal() ? adjusted.size() : given.size();
+}
+
+const std::vector<peak>& IncrementalAnalysis::getPeaks() const
+{
+  return peaks;
+}
+
+double IncrementalAnalysis::getShift() const
+{
+  return shift;
+}
@@ -0,0 +1,58 @@
+//class for an analysis that is brought up to date as the intensities of its spectrum change
+//every stage keeps its results, so an update only filters, refits, searches and integrates near the points that changed
+#pragma once
+#include "structs.h"
+#include "CubicSpline.h"
+#include "NoiseEstimate.h"
+#include <vector>
+#include <utility>
+#include <optional>
+
+class IncrementalAnalysis
+{
+  private:
+    //the options the analysis was run with
+    configuration config;
+    //the order the spectrum was given in (1=ascending, -1=descending, 0=neither)
+    int givenOrder;
+    //the spectrum as it was given, only kept when updates can't be local and the whole analysis is run again
+    std::vector<std::pair<double, double>> given;
+    //the points after the baseline is subtracted, from most positive to most negative x
+    std::vector<std::pair<double, double>> adjusted;
+    //the index in adjusted of the TMS peak, or its size if there isn't one
+    int tmsIndex;
+    //the points after filtering, in the same order as adjusted
+    std::vector<std::pair<double, double>> filtered;
+    std::optional<CubicSpline> spline;
+    //the noise of filtered, only kept when peaks are dropped below a signal to noise ratio
+    std::optional<NoiseEstimate> noiseEstimate;
+    //the roots of the spline in ascending order, and the region between each pair of them
+    std::vector<double> roots;
+    std::vector<peakRegion> regions;
+    //the results of the last update, with the TMS peak at x=0
+    std::vector<peak> peaks;
+    double shift;
+
+    //whether updates only redo the analysis near the points that changed
+    bool isLocal() const;
+    //changes the intensity of the ith point of filtered, keeping the noise estimate up to date
+    void setFiltered(int i, double intensity);
+    //filters the points of adjusted from first to last again, and returns the range of filtered that changed
+    std::pair<int, int> refilter(int first, int last);
+    //the tallest point of the spline between begin and end, found the same way as calculatePeaks
+    double regionHeight(double begin, double end) const;
+    //finds the peaks of every region that doesn't have them yet, then collects the peaks of the regions that are kept
+    void refreshPeaks();
+  public:
+    //runs the whole analysis on data with the options in config
+    IncrementalAnalysis(std::vector<std::pair<double, double>> data, const configuration& config);
+    //replaces the intensities of the points first, first+1, ... of the spectrum, counted in the order it was given in
+    //points can't be added, since every knot of the spline after them would move, so an appended spectrum is analyzed again
+    void update(int first, const std::vector<double>& intensities);
+    //how many points the spectrum has
+    int size() const;
+    //the peaks found by the last update, with the TMS peak at x=0
+    const std::vector<peak>& getPeaks() const;
+    //the x-value of the TMS peak
+    double getShift() const;
+};
@@ -1,22 +1,122 @@
-#include "CubicSpline.h"
-#include "structs.h"
-#include "prototypes.h"
+#include "nmr.h"
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <atomic>
+#include <csignal>
 
-int main()
+//set by SIGINT or SIGTERM to end watch mode once the spectra already read are analyzed
+std::atomic<bool> stopWatching(false);
+
+void requestStop(int)
+{
+  stopWatching = true;
+}
+
+//prints a line for a file as soon as it is finished
+void printResult(const fileResult& result)
+{
+  if(result.code != NMR_OK)
+  {
+    std::cerr << "Error: " << result.dataFile << ": " << result.error << std::endl;
+    return;
+  }
+  std::cout << result.dataFile << ": " << result.numPeaks << " peaks, written to " << result.reportFile
+            << " in " << 1000*result.latency << " ms (read " << 1000*result.readTime << ", queued " << 1000*result.queueTime
+            << ", analyzed " << 1000*result.analyzeTime << ", waited for the writer " << 1000*result.writeQueueTime
+            << ", wrote " << 1000*result.writeTime << ")" << std::endl;
+}
+
+//prints the totals over every file
+void printStats(const pipelineStats& stats)
+{
+  int numFiles = stats.filesDone + stats.filesFailed;
+  std::cout << std::endl << "Analyzed " << stats.filesDone << " files, " << stats.filesFailed << " failed" << std::endl;
+  if(numFiles > 0)
+    std::cout << "Latency: mean " << 1000*stats.totalLatency/numFiles << " ms, max " << 1000*stats.maxLatency << " ms" << std::endl;
+  std::cout << "Queue: at most " << stats.maxQueueDepth << " of " << stats.queueCapacity << " spectra waiting, "
+            << "reading waited for a worker " << stats.stalls << " times for " << 1000*stats.stallTime << " ms" << std::endl;
+  std::cout << "Writer: at most " << stats.maxWriteQueueDepth << " of " << stats.writeQueueCapacity << " results waiting, "
+            << "workers waited for it " << stats.writeStalls << " times" << std::endl;
+}
+
+//analyzes every spectrum written to the watched directory and prints a line for each one as it finishes
+//the totals are printed when the program is stopped
+int watch(Analyzer& analyzer)
 {
+  std::signal(SIGINT, requestStop);
+  std::signal(SIGTERM, requestStop);
+  std::string directory = analyzer.getConfig().watchDirectory;
+  std::cout << "Watching " << directory << " for .dat files, press Ctrl-C to stop" << std::endl;
+
+  pipelineStats stats;
+  if(analyzer.watch(directory, stopWatching, printResult, stats) != NMR_OK)
+  {
+    std::cerr << "Error: " << analyzer.lastError() << std::endl;
+    return 1;
+  }
+  printStats(stats);
+  return 0;
+}
+
+//analyzes every data file given on the command line, printing a line for each one as it finishes and then the totals
+//fails if any of them did
+int batch(Analyzer& analyzer)
+{
+  auto startTime = std::chrono::steady_clock::now();
+  pipelineStats stats;
+  if(analyzer.analyzeFiles(analyzer.getConfig().dataFiles, printResult, stats) != NMR_OK)
+  {
+    std::cerr << "Error: " << analyzer.lastError() << std::endl;
+    return 1;
+  }
+  std::chrono::duration<double> runtime = std::chrono::steady_clock::now() - startTime;
+  printStats(stats);
+  std::cout << "Throughput: " << (stats.filesDone + stats.filesFailed)/runtime.count() << " files/s over " << runtime.count() << " s" << std::endl;
+  return stats.filesFailed > 0 ? 1 : 0;
+}
+
+int main(int argc, char* argv[])
+{
+  for(int i = 1; i < argc; i++)
+  {
+    if(std::string(argv[i]) == "--help")
+    {
+      std::cout << optionUsage();
+      return 0;
+    }
+  }
+
   auto startTime = std::chrono::high_resolution_clock::now(); //start timer
-  auto config = readConfig("nmr.in"); //read in "nmr.in"
-  auto data = readData(config.inputFile);   //read in the nmr data
-  std::sort(data.rbegin(), data.rend());  //sort the data from most positive to most negative
+  Analyzer analyzer;
+  std::vector<peak> peaks;
   double shift = 0;
-  data = baselineAdjustment(data, config.baseline, shift); //shift the data based on TMS and baseline
-  data = filter(data, config.filterType, config.filterSize, config.numPasses);
-  CubicSpline spline(data); //construct a cubic spline from the data
-  auto peaks = calculatePeaks(spline, config.integrationTechnique, config.tolerance); //calculate the peak values
+  //read in the options, then read in the nmr data and calculate the peak values
+  if(analyzer.configure(argc, argv) != NMR_OK)
+  {
+    std::cerr << "Error: " << analyzer.lastError() << std::endl;
+    return 1;
+  }
+  if(!analyzer.getConfig().watchDirectory.empty())
+    return watch(analyzer);
+  if(!analyzer.getConfig().dataFiles.empty())
+    return batch(analyzer);
+  if(analyzer.analyzeFile(peaks, shift) != NMR_OK)
+  {
+    std::cerr << "Error: " << analyzer.lastError() << std::endl;
+    return 1;
+  }
 
   auto endTime = std::chrono::high_resolution_clock::now();
   std::chrono::duration<double> runtime = endTime - startTime; //calculate elapsed time
 
-  outputResult(peaks, config, shift, runtime.count());
+  std::string result;
+  if(analyzer.report(peaks, shift, runtime.count(), result) != NMR_OK || analyzer.writeReport(result) != NMR_OK)
+  {
+    std::cerr << "Error: " << analyzer.lastError() << std::endl;
+    return 1;
+  }
+  std::cout.write(result.data(), result.size()); //display output to stdout
+  std::cout.flush();
   return 0;
 }
@@ -0,0 +1,70 @@
+//the public interface of libnmr, for running the analysis from another program
+//nothing here exits or prints; every call returns an errorCode, and lastError describes what went wrong
+#pragma once
+#include "structs.h"
+#include <string>
+#include <vector>
+#include <utility>
+#include <memory>
+#include <atomic>
+#include <functional>
+
+class IncrementalAnalysis;
+
+//runs the analysis with one set of options on as many spectra as needed
+//configure has to succeed before anything is analyzed
+class Analyzer
+{
+  private:
+    //the options every run uses
+    configuration config;
+    //the memory the temporary buffers of each run come from, kept between runs so it's only allocated once
+    std::vector<char> arenaBuffer;
+    //a description of the last error
+    std::string error;
+    //the spectrum given to analyzeIncremental and everything found from it, so update can refresh it
+    std::unique_ptr<IncrementalAnalysis> incremental;
+
+    //runs f and turns any error it throws into an errorCode
+    template <typename F>
+    errorCode guard(F f);
+  public:
+    Analyzer();
+    ~Analyzer();
+    Analyzer(Analyzer&&);
+    Analyzer& operator=(Analyzer&&);
+    //checks the options in config and uses them for every run after this
+    errorCode configure(const configuration& config);
+    //reads the options from a configuration file, either in the format of nmr.in or key=value lines
+    errorCode configure(std::string fileName);
+    //reads the options from the command line, a configuration file and the environment, see optionUsage
+    errorCode configure(int argc, char* argv[]);
+    //the options every run uses
+    const configuration& getConfig() const;
+    //analyzes a spectrum in memory, filling in its peaks and the x-value of its TMS peak
+    errorCode analyze(const std::vector<std::pair<double, double>>& data, std::vector<peak>& peaks, double& shift);
+    //analyzes a spectrum like analyze, and keeps the results of every stage so update can refresh them
+    errorCode analyzeIncremental(const std::vector<std::pair<double, double>>& data, std::vector<peak>& peaks, double& shift);
+    //replaces the intensities of the points first, first+1, ... of the spectrum given to analyzeIncremental,
+    //counted in the order it was given in, and brings its peaks and the x-value of its TMS peak up to date
+    //only the cubics near the changed points are refitted and only the peaks near them are integrated again
+    errorCode update(int first, const std::vector<double>& intensities, std::vector<peak>& peaks, double& shift);
+    //reads the data file named in the options and analyzes it
+    errorCode analyzeFile(std::vector<peak>& peaks, double& shift);
+    //formats the results in the format chosen by the output file named in the options
+    errorCode report(const std::vector<peak>& peaks, double shift, double runtime, std::string& result);
+    //writes formatted results to the output file named in the options, if there is one
+    errorCode writeReport(const std::string& result);
+    //analyzes every file in dataFiles with the options of this Analyzer, and writes each report atomically next to its file
+    //the files are read on this thread, analyzed on a pool of workers and written by another thread, all at once
+    //onResult is called for every file, one call at a time, and stats has the totals once analyzeFiles returns
+    errorCode analyzeFiles(const std::vector<std::string>& dataFiles, std::function<void(const fileResult&)> onResult, pipelineStats& stats);
+    //analyzes every .dat file written to directory until stop is set, in the same way as analyzeFiles
+    //onResult is called for every file, one call at a time, and stats has the totals once watch returns
+    errorCode watch(std::string directory, const std::atomic<bool>& stop, std::function<void(const fileResult&)> onResult, pipelineStats& stats);
+    //a description of the last error
+    const std::string& lastError() const;
+};
+
+//a description of the command line options configure takes
+std::string optionUsage();
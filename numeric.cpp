@@ -0,0 +1,197 @@
+//implementation of numeric.h
+//each kernel has a self-contained version and an optional one from LAPACK or FFTW, chosen when the program is compiled
+#include "numeric.h"
+#include "structs.h"
+#include <vector>
+#include <complex>
+#include <cmath>
+#ifdef NMR_USE_FFTW
+#include <fftw3.h>
+#endif
+
+#ifdef NMR_USE_LAPACK
+extern "C"
+{
+  void dgtsv_(const int* n, const int* nrhs, double* dl, double* d, double* du, double* b, const int* ldb, int* info);
+  void dpbsv_(const char* uplo, const int* n, const int* kd, const int* nrhs, double* ab, const int* ldab, double* b, const int* ldb, int* info);
+}
+#endif
+
+#ifdef NMR_USE_LAPACK
+//solves the system with LAPACK's tridiagonal solver, which uses partial pivoting
+std::vector<double> solveTridiagonal(const std::vector<double>& lower, const std::vector<double>& diagonal, const std::vector<double>& upper, std::vector<double> b)
+{
+  int n = diagonal.size();
+  int nrhs = 1, info = 0;
+  std::vector<double> dl = lower, d = diagonal, du = upper;
+  dgtsv_(&n, &nrhs, dl.data(), d.data(), du.data(), b.data(), &n, &info);
+  if(info != 0)
+    throw nmrException{NMR_NUMERICAL, "tridiagonal system is singular"};
+  return b;
+}
+#else
+//solves the system with the Thomas algorithm, Gaussian elimination that only touches the three diagonals
+//takes O(n) time and memory
+std::vector<double> solveTridiagonal(const std::vector<double>& lower, const std::vector<double>& diagonal, const std::vector<double>& upper, std::vector<double> b)
+{
+  int n = diagonal.size();
+  //the upper diagonal after elimination, divided by the pivot of its row
+  std::vector<double> u(n, 0.0);
+  double pivot = diagonal[0];
+  if(n > 1)
+    u[0] = upper[0]/pivot;
+  b[0] /= pivot;
+  for(int i = 1; i < n; i++)
+  {
+    pivot = diagonal[i] - lower[i-1]*u[i-1];
+    if(i < n-1)
+      u[i] = upper[i]/pivot;
+    b[i] = (b[i] - lower[i-1]*b[i-1])/pivot;
+  }
+  for(int i = n-2; i >= 0; i--)
+    b[i] -= u[i]*b[i+1];
+  return b;
+}
+#endif
+
+#ifdef NMR_USE_LAPACK
+//solves the system with LAPACK's banded Cholesky solver
+std::vector<double> solvePentadiagonal(const std::vector<double>& d0, const std::vector<double>& d1, const std::vector<double>& d2, std::vector<double> b)
+{
+  int n = d0.size();
+  int kd = 2, ldab = 3, nrhs = 1, info = 0;
+  //the upper band in LAPACK's column major layout, with the main diagonal in the last row
+  std::vector<double> ab(ldab*n, 0.0);
+  for(int j = 0; j < n; j++)
+  {
+    ab[ldab*j + 2] = d0[j];
+    if(j >= 1)
+      ab[ldab*j + 1] = d1[j-1];
+    if(j >= 2)
+      ab[ldab*j] = d2[j-2];
+  }
+  dpbsv_("U", &n, &kd, &nrhs, ab.data(), &ldab, b.data(), &n, &info);
+  if(info != 0)
+    throw nmrException{NMR_NUMERICAL, "pentadiagonal system is not positive definite"};
+  return b;
+}
+#else
+//uses an LDL^T factorization, so it takes O(n) time and memory
+std::vector<double> solvePentadiagonal(const std::vector<double>& d0, const std::vector<double>& d1, const std::vector<double>& d2, std::vector<double> b)
+{
+  int n = d0.size();
+  //l1[i] = L(i,i-1) and l2[i] = L(i,i-2)
+  std::vector<double> d(n), l1(n, 0.0), l2(n, 0.0);
+  for(int i = 0; i < n; i++)
+  {
+    if(i >= 2)
+      l2[i] = d2[i-2]/d[i-2];
+    if(i >= 1)
+      l1[i] = (d1[i-1] - (i >= 2 ? l2[i]*d[i-2]*l1[i-1] : 0))/d[i-1];
+    d[i] = d0[i] - (i >= 1 ? l1[i]*l1[i]*d[i-1] : 0) - (i >= 2 ? l2[i]*l2[i]*d[i-2] : 0);
+  }
+
+  //solve L*y = b, then D*z = y, then L^T*x = z, all in place
+  for(int i = 1; i < n; i++)
+    b[i] -= l1[i]*b[i-1] + (i >= 2 ? l2[i]*b[i-2] : 0);
+  for(int i = 0; i < n; i++)
+    b[i] /= d[i];
+  for(int i = n-2; i >= 0; i--)
+    b[i] -= l1[i+1]*b[i+1] + (i+2 < n ? l2[i+2]*b[i+2] : 0);
+  return b;
+}
+#endif
+
+#ifdef NMR_USE_FFTW
+void fft(std::vector<std::complex<double>>& x, bool inverse)
+{
+  int n = x.size();
+  if(n <= 1)
+    return;
+  //std::complex<double> has the same layout as fftw_complex, so FFTW can transform x in place
+  fftw_complex* data = reinterpret_cast<fftw_complex*>(x.data());
+  fftw_plan plan = fftw_plan_dft_1d(n, data, data, inverse ? FFTW_BACKWARD : FFTW_FORWARD, FFTW_ESTIMATE);
+  fftw_execute(plan);
+  fftw_destroy_plan(plan);
+}
+#else
+//the iterative radix 2 Cooley-Tukey transform, for n a power of 2
+void radix2Fft(std::vector<std::complex<double>>& x, bool inverse)
+{
+  int n = x.size();
+  //put the elements in bit reversed order so the butterflies can work in place
+  for(int i = 1, j = 0; i < n; i++)
+  {
+    int bit = n >> 1;
+    for(; j & bit; bit >>= 1)
+      j ^= bit;
+    j ^= bit;
+    if(i < j)
+      std::swap(x[i], x[j]);
+  }
+
+  //every twiddle factor is computed directly instead of by repeated multiplication, so no rounding error builds up
+  double sign = inverse ? 1 : -1;
+  std::vector<std::complex<double>> twiddles(n/2);
+  for(int k = 0; k < n/2; k++)
+    twiddles[k] = std::polar(1.0, sign*2*M_PI*k/n);
+
+  for(int length = 2; length <= n; length <<= 1)
+  {
+    int half = length/2;
+    int stride = n/length;
+    for(int start = 0; start < n; start += length)
+    {
+      for(int k = 0; k < half; k++)
+      {
+        std::complex<double> odd = twiddles[k*stride]*x[start + k + half];
+        x[start + k + half] = x[start + k] - odd;
+        x[start + k] += odd;
+      }
+    }
+  }
+}
+
+//Bluestein's algorithm, for any n
+//jk = (j^2 + k^2 - (j-k)^2)/2 turns the transform into a convolution, which is done with power of 2 transforms
+void bluesteinFft(std::vector<std::complex<double>>& x, bool inverse)
+{
+  int n = x.size();
+  int m = 1;
+  while(m < 2*n-1)
+    m <<= 1;
+
+  //chirp[k] = e^(-+ pi i k^2/n), with k^2 reduced mod 2n first so the angle stays accurate for large k
+  double sign = inverse ? 1 : -1;
+  std::vector<std::complex<double>> chirp(n);
+  for(long long k = 0; k < n; k++)
+    chirp[k] = std::polar(1.0, sign*M_PI*((k*k) % (2LL*n))/n);
+
+  std::vector<std::complex<double>> a(m, 0.0), b(m, 0.0);
+  for(int k = 0; k < n; k++)
+    a[k] = x[k]*chirp[k];
+  b[0] = std::conj(chirp[0]);
+  for(int k = 1; k < n; k++)
+    b[k] = b[m-k] = std::conj(chirp[k]);
+
+  radix2Fft(a, false);
+  radix2Fft(b, false);
+  for(int k = 0; k < m; k++)
+    a[k] *= b[k];
+  radix2Fft(a, true);
+
+  for(int k = 0; k < n; k++)
+    x[k] = chirp[k]*a[k]/double(m);
+}
+
+void fft(std::vector<std::complex<double>>& x, bool inverse)
+{
+  int n = x.size();
+  if(n <= 1)
+    return;
+  if((n & (n-1)) == 0)
+    radix2Fft(x, inverse);
+  else
+    bluesteinFft(x, inverse);
+}
+#endif
@@ -0,0 +1,16 @@
+//the numerical kernels the rest of the analysis is built on: banded linear solves and the fast Fourier transform
+//they are self-contained by default, or use LAPACK and FFTW when built with make LAPACK=1 and make FFTW=1
+#pragma once
+#include <vector>
+#include <complex>
+
+//solves A*x = b where A is tridiagonal
+//lower is the diagonal below the main one, diagonal the main one and upper the one above it
+//A must not need pivoting, which is true when it is diagonally dominant like the spline's system
+std::vector<double> solveTridiagonal(const std::vector<double>& lower, const std::vector<double>& diagonal, const std::vector<double>& upper, std::vector<double> b);
+//solves A*x = b where A is symmetric, positive definite and pentadiagonal
+//d0 is the main diagonal, d1 the diagonal above it and d2 the one above that
+std::vector<double> solvePentadiagonal(const std::vector<double>& d0, const std::vector<double>& d1, const std::vector<double>& d2, std::vector<double> b);
+//replaces x with its discrete Fourier transform, sum_k x_k e^(-2 pi i jk/n), in O(n log n) time for any n
+//inverse flips the sign of the exponent; neither direction is scaled by 1/n
+void fft(std::vector<std::complex<double>>& x, bool inverse);
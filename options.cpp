@@ -0,0 +1,259 @@
+//functions for setting options by name, from key=value files, environment variables and the command line
+//every source goes through setOption, so they all accept the same names and values
+#include "structs.h"
+#include "prototypes.h"
+#include "nmr.h"
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <vector>
+#include <utility>
+#include <cstdlib>
+#include <cctype>
+
+//an option that can be set by name
+struct optionInfo
+{
+  std::string key, description;
+};
+
+const optionInfo optionList[] = {
+  {"input", "name of the data file"},
+  {"output", "name of the output file, - writes the results to stdout only"},
+  {"baseline", "baseline adjustment"},
+  {"tolerance", "tolerance for numerical algorithms"},
+  {"filter", "type of filter (0=none, 1=boxcar, 2=SG, 3=DFT)"},
+  {"filterSize", "size of the boxcar or SG filter, 0 turns filtering off"},
+  {"passes", "number of passes for the filter"},
+  {"integration", "integration technique (0=adaptive, 1=Romberg, 2=Newton-Cotes, 3=quadrature)"},
+  {"peakModel", "peak fitting model (0=none, 1=Lorentzian, 2=Gaussian, 3=pseudo-Voigt)"},
+  {"peakDetection", "peak detection (0=midpoint, 1=apex, 2=apex and split multiplets)"},
+  {"baselineMode", "baseline correction (0=constant, 1=polynomial, 2=asymmetric least squares)"},
+  {"minSnr", "minimum signal to noise ratio of a peak (0=keep every peak)"},
+  {"quadratureOrder", "Gaussian quadrature points per spline segment (1 to 1024)"},
+  {"kronrodOrder", "Gauss-Kronrod order for adaptive quadrature (1 to 1024)"},
+  {"precision", "filter precision (0=double, 1=single)"},
+  {"threads", "threads used to sort the data and fit the peaks, or workers for several files or watch mode (0=every core)"},
+  {"format", "output format (text, json or csv), by default chosen by the output file's extension"},
+  {"watch", "directory to watch, every .dat file written to it is analyzed and gets a report next to it"}
+};
+
+//returns s without the whitespace at either end
+std::string trim(const std::string& s)
+{
+  size_t first = s.find_first_not_of(" \t\r\n");
+  if(first == std::string::npos)
+    return "";
+  size_t last = s.find_last_not_of(" \t\r\n");
+  return s.substr(first, last - first + 1);
+}
+
+//reads value as a T, throwing an invalid option error unless all of it is used
+template <typename T>
+T parseValue(const std::string& key, const std::string& value)
+{
+  std::istringstream in(value);
+  T result;
+  char extra;
+  if(!(in >> result) || (in >> extra))
+    throw nmrException{NMR_INVALID_OPTION, "option " + key + " has an invalid value \"" + value + "\"."};
+  return result;
+}
+
+//sets the option named key from its value written as text
+//throws an invalid option error for an unknown key or a value that isn't a number where one is needed
+//values are only checked for range by validateConfig, once every source has been read
+void setOption(configuration& config, std::string key, std::string value)
+{
+  if(key == "input")
+    config.inputFile = value;
+  else if(key == "output")
+    config.outputFile = value;
+  else if(key == "baseline")
+    config.baseline = parseValue<double>(key, value);
+  else if(key == "tolerance")
+    config.tolerance = parseValue<double>(key, value);
+  else if(key == "filter")
+    config.filterType = parseValue<int>(key, value);
+  else if(key == "filterSize")
+    config.filterSize = parseValue<int>(key, value);
+  else if(key == "passes")
+    config.numPasses = parseValue<int>(key, value);
+  else if(key == "integration")
+    config.integrationTechnique = parseValue<int>(key, value);
+  else if(key == "peakModel")
+    config.peakModel = parseValue<int>(key, value);
+  else if(key == "peakDetection")
+    config.peakDetection = parseValue<int>(key, value);
+  else if(key == "baselineMode")
+    config.baselineMode = parseValue<int>(key, value);
+  else if(key == "minSnr")
+    config.minSnr = parseValue<double>(key, value);
+  else if(key == "quadratureOrder")
+    config.quadratureOrder = parseValue<int>(key, value);
+  else if(key == "kronrodOrder")
+    config.kronrodOrder = parseValue<int>(key, value);
+  else if(key == "precision")
+    config.precision = parseValue<int>(key, value);
+  else if(key == "threads")
+    config.numThreads = parseValue<int>(key, value);
+  else if(key == "format")
+    config.format = value;
+  else if(key == "watch")
+    config.watchDirectory = value;
+  else
+    throw nmrException{NMR_INVALID_OPTION, "unknown option " + key + "."};
+}
+
+//reads key=value lines into config, where # starts a comment and blank lines are skipped
+//fileName is only used to say where an error is
+void readOptions(std::istream& in, configuration& config, std::string fileName)
+{
+  std::string line;
+  for(int lineNumber = 1; std::getline(in, line); lineNumber++)
+  {
+    line = trim(line.substr(0, line.find('#')));
+    if(line.empty())
+      continue;
+    size_t equals = line.find('=');
+    if(equals == std::string::npos)
+      throw nmrException{NMR_CONFIG_FILE, fileName + " line " + std::to_string(lineNumber) + " is not of the form key=value"};
+    try
+    {
+      setOption(config, trim(line.substr(0, equals)), trim(line.substr(equals+1)));
+    }
+    catch(nmrException& e)
+    {
+      e.message = fileName + " line " + std::to_string(lineNumber) + ": " + e.message;
+      throw;
+    }
+  }
+}
+
+//returns the environment variable that overrides the option named key, NMR_ followed by the key in upper snake case
+std::string environmentName(const std::string& key)
+{
+  std::string name = "NMR";
+  for(char c : key)
+  {
+    if(isupper(c))
+      name += '_';
+    else if(name.size() == 3)
+      name += '_';
+    name += toupper(c);
+  }
+  return name;
+}
+
+//sets every option that has an environment variable, so NMR_TOLERANCE=1e-8 sets the tolerance
+void readEnvironment(configuration& config)
+{
+  for(auto & option : optionList)
+  {
+    std::string name = environmentName(option.key);
+    const char* value = getenv(name.c_str());
+    if(value == nullptr)
+      continue;
+    try
+    {
+      setOption(config, option.key, value);
+    }
+    catch(nmrException& e)
+    {
+      e.message = "environment variable " + name + ": " + e.message;
+      throw;
+    }
+  }
+}
+
+//builds the options from every source, each overriding the ones before it:
+//the defaults, a configuration file, environment variables and then the command line
+//the file is the one given by --config, or NMR_CONFIG, or nmr.in if there is one in the current directory
+//flags are written --key value or --key=value; the options are checked once, after all of them are read
+//any other argument is a data file, and with more than one of them each is analyzed and gets a report next to it
+configuration parseOptions(int argc, char* argv[])
+{
+  std::string configFile;
+  std::vector<std::pair<std::string, std::string>> flags;
+  std::vector<std::string> dataFiles;
+  for(int i = 1; i < argc; i++)
+  {
+    std::string argument = argv[i];
+    if(argument.compare(0, 2, "--") != 0)
+    {
+      dataFiles.push_back(argument);
+      continue;
+    }
+    if(argument.size() == 2)
+      throw nmrException{NMR_INVALID_OPTION, "unexpected argument " + argument + "."};
+
+    std::string key = argument.substr(2), value;
+    size_t equals = key.find('=');
+    if(equals != std::string::npos)
+    {
+      value = key.substr(equals+1);
+      key = key.substr(0, equals);
+    }
+    else if(i+1 < argc)
+      value = argv[++i];
+    else
+      throw nmrException{NMR_INVALID_OPTION, "option --" + key + " needs a value."};
+
+    if(key == "config")
+      configFile = value;
+    else
+      flags.push_back({key, value});
+  }
+
+  if(configFile.empty() && getenv("NMR_CONFIG") != nullptr)
+    configFile = getenv("NMR_CONFIG");
+  if(configFile.empty() && std::ifstream("nmr.in"))
+    configFile = "nmr.in";
+
+  configuration config;
+  if(!configFile.empty())
+    config = readConfigFile(configFile);
+  readEnvironment(config);
+  for(auto & flag : flags)
+  {
+    try
+    {
+      setOption(config, flag.first, flag.second);
+    }
+    catch(nmrException& e)
+    {
+      e.message = "--" + flag.first + ": " + e.message;
+      throw;
+    }
+  }
+
+  //a single data file is just the input file, so it is reported the same way as one given with --input
+  if(dataFiles.size() == 1)
+    config.inputFile = dataFiles[0];
+  else
+    config.dataFiles = dataFiles;
+
+  finishConfig(config);
+  validateConfig(config);
+  //the library can analyze spectra in memory, but the program always reads them from files or watches for them
+  if(config.inputFile.empty() && config.dataFiles.empty() && config.watchDirectory.empty())
+    throw nmrException{NMR_INVALID_OPTION, "no data file was given."};
+  return config;
+}
+
+//a description of the command line options
+std::string optionUsage()
+{
+  std::stringstream out;
+  out << "Usage: nmrAnalyzer [--config FILE] [--key value | --key=value]... [DATA FILE]..." << std::endl << std::endl;
+  out << "With more than one data file, they are read, analyzed and written at the same time, and each report is written next to its file." << std::endl;
+  out << "Options are read from the defaults, then a configuration file, then environment variables and then the command line, each overriding the ones before it." << std::endl;
+  out << "The configuration file is FILE, or $NMR_CONFIG, or nmr.in if there is one in the current directory." << std::endl;
+  out << "It is either in the positional format of nmr.in or has one key=value line per option." << std::endl << std::endl;
+  for(auto & option : optionList)
+  {
+    std::string flag = "--" + option.key;
+    out << "  " << flag << std::string(flag.size() < 18 ? 18 - flag.size() : 1, ' ') << option.description << " [" << environmentName(option.key) << "]" << std::endl;
+  }
+  return out.str();
+}
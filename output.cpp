@@ -1,4 +1,4 @@
-//functions for outputting results to a file and to stdout
+//functions for formatting the results and writing them to a file
 #include "structs.h"
 #include <iostream>
 #include <iomanip>
@@ -6,6 +6,18 @@
 #include <fstream>
 #include <vector>
 #include <chrono>
+#include <string>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <unistd.h>
+
+const std::string filterNames[] = {"None", "Boxcar", "Savitzky-Golay", "Discrete Fourier Transform"};
+const std::string methodNames[] = {"Adaptive Quadrature", "Romberg", "Composite Newton-Cotes", "Gaussian Quadrature"};
+const std::string modelNames[] = {"None", "Lorentzian", "Gaussian", "Pseudo-Voigt"};
+const std::string detectionNames[] = {"Midpoint", "Apex", "Apex With Multiplet Splitting"};
+const std::string baselineNames[] = {"Constant", "Polynomial", "Asymmetric Least Squares"};
+const std::string precisionNames[] = {"Double", "Single"};
 
 std::string printOptions(configuration config, double shift)
 {
@@ -13,7 +25,11 @@ std::string printOptions(configuration config, double shift)
   out << "Program Options" << std::endl;
   out << "===============================" << std::endl;
   out << "Baseline Adjustment\t:\t" << config.baseline << std::endl;
+  if(config.baselineMode != 0)
+    out << "Baseline Correction\t:\t" << baselineNames[config.baselineMode] << std::endl;
   out << "Tolerance\t\t:\t" << config.tolerance << std::endl;
+  if(config.minSnr > 0)
+    out << "Minimum SNR\t\t:\t" << config.minSnr << std::endl;
   switch(config.filterType)
   {
     case 0:
@@ -23,11 +39,15 @@ std::string printOptions(configuration config, double shift)
       out << "Boxcar Filtering" << std::endl;
       out << "Boxcar Size (Cyclic)\t:\t" << config.filterSize << std::endl;
       out << "Boxcar Passes\t\t:\t" << config.numPasses << std::endl;
+      if(config.precision != 0)
+        out << "Filter Precision\t:\t" << precisionNames[config.precision] << std::endl;
       break;
     case 2:
       out << "Savitzky-Golay Filtering" << std::endl;
       out << "SG Filter Size\t\t:\t" << config.filterSize << std::endl;
       out << "SG Filter Passes\t:\t" << config.numPasses << std::endl;
+      if(config.precision != 0)
+        out << "Filter Precision\t:\t" << precisionNames[config.precision] << std::endl;
       break;
     case 3:
       out << "Discrete Fourier Transform Filtering" << std::endl;
@@ -36,8 +56,24 @@ std::string printOptions(configuration config, double shift)
   out << std::endl;
   out << "Integration Method" << std::endl;
   out << "===============================" << std::endl;
-  const std::string methods[] = {"Adaptive Quadrature", "Romberg", "Composite Newton-Cotes", "Gaussian Quadrature"};
-  out << methods[config.integrationTechnique] << std::endl << std::endl;
+  out << methodNames[config.integrationTechnique] << std::endl;
+  if(config.integrationTechnique == 3)
+    out << config.quadratureOrder << " points per spline segment" << std::endl;
+  if(config.integrationTechnique == 0)
+    out << config.kronrodOrder << " point Gauss, " << 2*config.kronrodOrder+1 << " point Kronrod rule" << std::endl;
+  out << std::endl;
+  if(config.peakDetection != 0)
+  {
+    out << "Peak Detection" << std::endl;
+    out << "===============================" << std::endl;
+    out << detectionNames[config.peakDetection] << std::endl << std::endl;
+  }
+  if(config.peakModel != 0)
+  {
+    out << "Peak Fitting" << std::endl;
+    out << "===============================" << std::endl;
+    out << modelNames[config.peakModel] << " lines" << std::endl << std::endl;
+  }
   out << "Plot File Data" << std::endl;
   out << "===============================" << std::endl;
   out << "File:\t" << config.inputFile << std::endl;
@@ -69,13 +105,278 @@ std::string printPeaks(std::vector<peak> peaks)
   return out.str();
 }
 
-void outputResult(std::vector<peak> peaks, configuration config, double shift, double runtime)
+//appends x to out in the shortest form that reads back as the same double
+//JSON has no representation of infinity or NaN, so they are written as null
+void appendNumber(std::string& out, double x)
+{
+  if(!std::isfinite(x))
+  {
+    out += "null";
+    return;
+  }
+  char digits[32];
+  auto result = std::to_chars(digits, digits + sizeof(digits), x);
+  out.append(digits, result.ptr);
+}
+
+void appendNumber(std::string& out, int x)
+{
+  char digits[16];
+  auto result = std::to_chars(digits, digits + sizeof(digits), x);
+  out.append(digits, result.ptr);
+}
+
+//appends s to out as a quoted JSON string
+//every control character is escaped, since JSON doesn't allow any of them inside a string
+void appendString(std::string& out, std::string s)
+{
+  out += '"';
+  for(char c : s)
+  {
+    if(c == '"' || c == '\\')
+    {
+      out += '\\';
+      out += c;
+    }
+    else if(c == '\n')
+      out += "\\n";
+    else if(c == '\t')
+      out += "\\t";
+    else if(static_cast<unsigned char>(c) < 0x20)
+    {
+      char escaped[8];
+      snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(c));
+      out += escaped;
+    }
+    else
+      out += c;
+  }
+  out += '"';
+}
+
+//appends s to out as a quoted CSV field, with any quotes in it doubled
+void appendCsvField(std::string& out, std::string s)
+{
+  out += '"';
+  for(char c : s)
+  {
+    if(c == '"')
+      out += '"';
+    out += c;
+  }
+  out += '"';
+}
+
+//appends "key": to out
+void appendKey(std::string& out, std::string key)
+{
+  appendString(out, key);
+  out += ": ";
+}
+
+//formats the options, peaks and runtime as a JSON document
+std::string printJson(std::vector<peak> peaks, configuration config, double shift, double runtime)
+{
+  std::string out;
+  int numLines = 0;
+  for(peak & p : peaks)
+    numLines += p.lines.size();
+  //an estimate of the size, with room for the file name even if every character has to be escaped as \u00XX,
+  //so the buffer usually doesn't have to grow
+  out.reserve(512 + 6*config.inputFile.size() + 160*peaks.size() + 128*numLines);
+
+  out += "{\n  ";
+  appendKey(out, "options");
+  out += "{\n    ";
+  appendKey(out, "inputFile"); appendString(out, config.inputFile); out += ",\n    ";
+  appendKey(out, "baseline"); appendNumber(out, config.baseline); out += ",\n    ";
+  appendKey(out, "baselineCorrection"); appendString(out, baselineNames[config.baselineMode]); out += ",\n    ";
+  appendKey(out, "tolerance"); appendNumber(out, config.tolerance); out += ",\n    ";
+  appendKey(out, "filter"); appendString(out, filterNames[config.filterType]); out += ",\n    ";
+  appendKey(out, "filterSize"); appendNumber(out, config.filterSize); out += ",\n    ";
+  appendKey(out, "numPasses"); appendNumber(out, config.numPasses); out += ",\n    ";
+  appendKey(out, "integration"); appendString(out, methodNames[config.integrationTechnique]); out += ",\n    ";
+  appendKey(out, "quadratureOrder"); appendNumber(out, config.quadratureOrder); out += ",\n    ";
+  appendKey(out, "kronrodOrder"); appendNumber(out, config.kronrodOrder); out += ",\n    ";
+  appendKey(out, "precision"); appendString(out, precisionNames[config.precision]); out += ",\n    ";
+  appendKey(out, "peakModel"); appendString(out, modelNames[config.peakModel]); out += ",\n    ";
+  appendKey(out, "peakDetection"); appendString(out, detectionNames[config.peakDetection]); out += ",\n    ";
+  appendKey(out, "minSnr"); appendNumber(out, config.minSnr); out += ",\n    ";
+  appendKey(out, "shift"); appendNumber(out, shift);
+  out += "\n  },\n  ";
+
+  appendKey(out, "peaks");
+  out += "[";
+  for(int i = 0; i < peaks.size(); i++)
+  {
+    out += i == 0 ? "\n    {" : ",\n    {";
+    appendKey(out, "peak"); appendNumber(out, i+1); out += ", ";
+    appendKey(out, "begin"); appendNumber(out, peaks[i].begin); out += ", ";
+    appendKey(out, "end"); appendNumber(out, peaks[i].end); out += ", ";
+    appendKey(out, "location"); appendNumber(out, peaks[i].location); out += ", ";
+    appendKey(out, "area"); appendNumber(out, peaks[i].area); out += ", ";
+    appendKey(out, "hydrogens"); appendNumber(out, peaks[i].numHydrogens);
+    if(config.peakDetection != 0)
+    {
+      out += ", ";
+      appendKey(out, "height"); appendNumber(out, peaks[i].height); out += ", ";
+      appendKey(out, "width"); appendNumber(out, peaks[i].width); out += ", ";
+      appendKey(out, "leftInflection"); appendNumber(out, peaks[i].leftInflection); out += ", ";
+      appendKey(out, "rightInflection"); appendNumber(out, peaks[i].rightInflection);
+    }
+    if(config.minSnr > 0)
+    {
+      out += ", ";
+      appendKey(out, "snr"); appendNumber(out, peaks[i].snr);
+    }
+    if(!peaks[i].lines.empty())
+    {
+      out += ", ";
+      appendKey(out, "lines");
+      out += "[";
+      for(int j = 0; j < peaks[i].lines.size(); j++)
+      {
+        const lineShape& line = peaks[i].lines[j];
+        out += j == 0 ? "{" : ", {";
+        appendKey(out, "center"); appendNumber(out, line.center); out += ", ";
+        appendKey(out, "height"); appendNumber(out, line.height); out += ", ";
+        appendKey(out, "width"); appendNumber(out, line.width); out += ", ";
+        appendKey(out, "eta"); appendNumber(out, line.eta);
+        out += "}";
+      }
+      out += "]";
+    }
+    out += "}";
+  }
+  out += peaks.empty() ? "],\n  " : "\n  ],\n  ";
+
+  appendKey(out, "runtime"); appendNumber(out, runtime);
+  out += "\n}\n";
+  return out;
+}
+
+//formats the peaks as CSV, with the same fields as the JSON document
+//the options and runtime come first as comment lines starting with #
+//when peaks were fitted, a second table with a row for every fitted line follows the peaks after a blank line
+std::string printCsv(std::vector<peak> peaks, configuration config, double shift, double runtime)
+{
+  std::string out;
+  //an estimate of the size, with room for the file name even if it is all quotes, so the buffer usually doesn't have to grow
+  out.reserve(512 + 2*config.inputFile.size() + 128*peaks.size());
+
+  out += "# inputFile,"; appendCsvField(out, config.inputFile); out += "\n";
+  out += "# baseline,"; appendNumber(out, config.baseline); out += "\n";
+  out += "# baselineCorrection," + baselineNames[config.baselineMode] + "\n";
+  out += "# tolerance,"; appendNumber(out, config.tolerance); out += "\n";
+  out += "# filter," + filterNames[config.filterType] + "\n";
+  out += "# filterSize,"; appendNumber(out, config.filterSize); out += "\n";
+  out += "# numPasses,"; appendNumber(out, config.numPasses); out += "\n";
+  out += "# integration," + methodNames[config.integrationTechnique] + "\n";
+  out += "# quadratureOrder,"; appendNumber(out, config.quadratureOrder); out += "\n";
+  out += "# kronrodOrder,"; appendNumber(out, config.kronrodOrder); out += "\n";
+  out += "# precision," + precisionNames[config.precision] + "\n";
+  out += "# peakModel," + modelNames[config.peakModel] + "\n";
+  out += "# peakDetection," + detectionNames[config.peakDetection] + "\n";
+  out += "# minSnr,"; appendNumber(out, config.minSnr); out += "\n";
+  out += "# shift,"; appendNumber(out, shift); out += "\n";
+  out += "# runtime,"; appendNumber(out, runtime); out += "\n";
+
+  out += "peak,begin,end,location,area,hydrogens";
+  if(config.peakDetection != 0)
+    out += ",height,width,leftInflection,rightInflection";
+  if(config.minSnr > 0)
+    out += ",snr";
+  out += '\n';
+  int numLines = 0;
+  for(int i = 0; i < peaks.size(); i++)
+  {
+    appendNumber(out, i+1); out += ',';
+    appendNumber(out, peaks[i].begin); out += ',';
+    appendNumber(out, peaks[i].end); out += ',';
+    appendNumber(out, peaks[i].location); out += ',';
+    appendNumber(out, peaks[i].area); out += ',';
+    appendNumber(out, peaks[i].numHydrogens);
+    if(config.peakDetection != 0)
+    {
+      out += ',';
+      appendNumber(out, peaks[i].height); out += ',';
+      appendNumber(out, peaks[i].width); out += ',';
+      appendNumber(out, peaks[i].leftInflection); out += ',';
+      appendNumber(out, peaks[i].rightInflection);
+    }
+    if(config.minSnr > 0)
+    {
+      out += ',';
+      appendNumber(out, peaks[i].snr);
+    }
+    out += '\n';
+    numLines += peaks[i].lines.size();
+  }
+
+  //the lines refer to their peak by its number in the first table
+  if(numLines > 0)
+  {
+    out += "\npeak,line,center,height,width,eta\n";
+    for(int i = 0; i < peaks.size(); i++)
+      for(int j = 0; j < peaks[i].lines.size(); j++)
+      {
+        const lineShape& line = peaks[i].lines[j];
+        appendNumber(out, i+1); out += ',';
+        appendNumber(out, j+1); out += ',';
+        appendNumber(out, line.center); out += ',';
+        appendNumber(out, line.height); out += ',';
+        appendNumber(out, line.width); out += ',';
+        appendNumber(out, line.eta);
+        out += '\n';
+      }
+  }
+  return out;
+}
+
+//formats the results as the human readable report
+std::string printText(std::vector<peak> peaks, configuration config, double shift, double runtime)
+{
+  std::stringstream out;
+  out << "                              -=> NMR ANALYSIS <=-" << std::endl << std::endl << std::endl;
+  out << printOptions(config, shift);
+  out << printPeaks(peaks);
+  out << "Analysis took " << runtime << " seconds." << std::endl;
+  return out.str();
+}
+
+//returns true if fileName ends with extension
+bool hasExtension(std::string fileName, std::string extension)
+{
+  return fileName.size() >= extension.size() && fileName.compare(fileName.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+//formats the results in the format chosen by the format option,
+//or if it isn't set by the extension of the output file: .json, .csv, or the text report for anything else
+std::string formatResult(std::vector<peak> peaks, configuration config, double shift, double runtime)
 {
-  std::ofstream outFile(config.outputFile.c_str());
-  outFile << "                              -=> NMR ANALYSIS <=-" << std::endl << std::endl << std::endl;
-  outFile << printOptions(config, shift);
-  outFile << printPeaks(peaks);
-  outFile << "Analysis took " << runtime << " seconds." << std::endl;
+  if(config.format == "json" || (config.format.empty() && hasExtension(config.outputFile, ".json")))
+    return printJson(peaks, config, shift, runtime);
+  else if(config.format == "csv" || (config.format.empty() && hasExtension(config.outputFile, ".csv")))
+    return printCsv(peaks, config, shift, runtime);
+  else
+    return printText(peaks, config, shift, runtime);
+}
+
+//writes the formatted results to fileName, throwing an error if it can't be written
+//no file is written if fileName is empty or -
+//the results are written to a temporary file that is then renamed to fileName,
+//so anything reading fileName sees either the old results or all of the new ones, never part of them
+void writeResult(const std::string& result, std::string fileName)
+{
+  if(fileName.empty() || fileName == "-")
+    return;
+  std::string temporary = fileName + ".tmp" + std::to_string(getpid());
+  std::ofstream outFile(temporary.c_str(), std::ios::binary);
+  outFile.write(result.data(), result.size());
   outFile.close();
-  system(("cat " + config.outputFile).c_str()); //display output to stdout
+  if(!outFile || std::rename(temporary.c_str(), fileName.c_str()) != 0)
+  {
+    std::remove(temporary.c_str());
+    throw nmrException{NMR_OUTPUT_FILE, "could not write output file " + fileName};
+  }
 }
@@ -2,61 +2,175 @@
 //finds their start and endpoints, their area, and their location
 #include "structs.h" //peak struct is included here
 #include "CubicSpline.h"
-#include "legendreConstants.h"
+#include "prototypes.h"
+#include "arena.h"
+#include "NoiseEstimate.h"
 #include <vector>
 #include <algorithm>
 #include <functional>
 #include <cmath>
-#include <gsl/gsl_poly.h>
+#include <array>
+#include <memory_resource>
 
 #define MAX_ITERATIONS 1000
-#define MAX_RECURSION_DEPTH 10
-
-//finds all the x values on the interval (a,b] where p(x) = 0
-//p is assumed to be a cubic polynomial
-std::vector<double> findRoots(Polynomial p, double start, double end)
-{
-  //consider a cubic of the form x^3+ax^2+bx+c
-  double a = p[2]/p[3];
-  double b = p[1]/p[3];
-  double c = p[0]/p[3];
-
-  double x0, x1, x2;
-  int numRoots =  gsl_poly_solve_cubic(a, b, c, &x0, &x1, &x2);
-
-  std::vector<double> roots;
-  switch (numRoots)
-  {
-    case 3:
-      if(start<x2 && x2<=end)
-        roots.push_back(x2);
-    case 2:
-      if(start<x1 && x1<=end)
-        roots.push_back(x1);
-    case 1:
-      if(start<x0 && x0<=end)
-        roots.push_back(x0);
-      break;
+//adaptive quadrature stops after splitting this many pieces
+#define MAX_INTERVALS 1000
+//the most rows of the extrapolation table Romberg integration computes; the last row samples 2^(ROMBERG_MAX_ROWS-2) points
+#define ROMBERG_MAX_ROWS 24
+//brackets are refined until they are narrower than this fraction of their cubic's interval
+#define ROOT_TOLERANCE 1e-13
+//safeguarded Newton's method takes at most this many steps, enough for bisection alone to reach machine precision
+#define ROOT_ITERATIONS 64
+
+//evaluates a function at the n x-values starting at xs, which are in ascending order, and stores the results starting at ys
+typedef std::function<void(const double* xs, int n, double* ys)> batchFunction;
+
+//1/(4^j - 1), the weight of the jth column of the Romberg table in Richardson extrapolation
+constexpr std::array<double, ROMBERG_MAX_ROWS> makeRombergFactors()
+{
+  std::array<double, ROMBERG_MAX_ROWS> factors{};
+  double power = 4;
+  for(int j = 1; j < ROMBERG_MAX_ROWS; j++)
+  {
+    factors[j] = 1/(power - 1);
+    power *= 4;
   }
+  return factors;
+}
+constexpr std::array<double, ROMBERG_MAX_ROWS> rombergFactors = makeRombergFactors();
 
-  //it is necessary for the roots to be sorted for when we iterate through them later
-  std::sort(roots.begin(), roots.end());
+//returns false if the local cubic q provably has no root for t on the interval [0,h]
+//the Bernstein coefficients of q on [0,h] bound it from above and below,
+//so if they all have the same sign then q has that sign over the whole interval
+bool mayHaveRoot(const FixedPolynomial<3>& q, double h)
+{
+  double b0 = q[0];
+  double b1 = q[0] + q[1]*h/3;
+  double b2 = q[0] + (2*q[1] + q[2]*h)*h/3;
+  double b3 = q.evaluate(h);
+  bool positive = b0 > 0 && b1 > 0 && b2 > 0 && b3 > 0;
+  bool negative = b0 < 0 && b1 < 0 && b2 < 0 && b3 < 0;
+  return !positive && !negative;
+}
 
-  return roots;
+//finds the points strictly inside (0,h) where the derivative of the local cubic q is 0, in ascending order
+//q is monotone between consecutive points
+int findCriticalPoints(const FixedPolynomial<3>& q, double h, double points[2])
+{
+  //q'(t) = b + 2ct + 3dt^2
+  double a = 3*q[3], b = 2*q[2], c = q[1];
+  double roots[2];
+  int numRoots = 0;
+  if(a == 0)
+  {
+    if(b != 0)
+      roots[numRoots++] = -c/b;
+  }
+  else
+  {
+    double discriminant = b*b - 4*a*c;
+    if(discriminant > 0)
+    {
+      //avoid cancellation by never subtracting numbers of the same sign
+      double temp = -0.5*(b + std::copysign(sqrt(discriminant), b));
+      roots[0] = temp/a;
+      roots[1] = temp != 0 ? c/temp : -roots[0];
+      if(roots[0] > roots[1])
+        std::swap(roots[0], roots[1]);
+      numRoots = 2;
+    }
+  }
+
+  int numPoints = 0;
+  for(int i = 0; i < numRoots; i++)
+    if(0 < roots[i] && roots[i] < h)
+      points[numPoints++] = roots[i];
+  return numPoints;
 }
 
-//finds all the x-values at which the cubic spline intersects the x-axis
-std::vector<double> findRoots(CubicSpline spline)
+//finds all the x-values at which the cubic spline intersects the x-axis, in ascending order
+//each root belongs to the cubic whose interval (x_i, x_i+1] it falls in, so no root is found twice
+//works on the local cubics, whose coefficients stay well scaled however far the spectrum is from 0
+//only the cubics first to last are searched, or every cubic from first on if last is -1
+std::vector<double> findRoots(const CubicSpline& spline, int first, int last)
 {
-  std::vector<double> roots;
-  //iterate through each cubic of the spline and accumulate their roots
-  for(int i = 0; i < spline.getNumCubics(); i++)
+  if(last == -1)
+    last = spline.getNumCubics() - 1;
+
+  //most cubics are baseline noise that never crosses zero, so first prune every cubic that provably can't
+  std::pmr::vector<int> candidates(scratch());
+  for(int i = first; i <= last; i++)
+  {
+    std::pair<double,double> range = spline.getRange(i);
+    if(mayHaveRoot(spline.getLocalCubic(i), range.second - range.first))
+      candidates.push_back(i);
+  }
+
+  //split each candidate into pieces where it is monotone and keep the pieces that change sign
+  //every piece brackets exactly one root; the brackets are stored column by column so they can be refined together
+  std::pmr::vector<double> starts(scratch()), lefts(scratch()), rights(scratch()), leftSigns(scratch()), widths(scratch());
+  std::pmr::vector<double> qa(scratch()), qb(scratch()), qc(scratch()), qd(scratch());
+  for(int i : candidates)
   {
-    Polynomial cubic = spline[i];
+    const FixedPolynomial<3>& q = spline.getLocalCubic(i);
     std::pair<double,double> range = spline.getRange(i);
-    std::vector<double> intermediateRoots = findRoots(cubic, range.first, range.second);
-    roots.insert(roots.end(), intermediateRoots.begin(), intermediateRoots.end());
+    double h = range.second - range.first;
+
+    double points[4] = {0};
+    int numPoints = 1 + findCriticalPoints(q, h, points+1);
+    points[numPoints++] = h;
+    for(int j = 0; j+1 < numPoints; j++)
+    {
+      double fLeft = q.evaluate(points[j]);
+      double fRight = q.evaluate(points[j+1]);
+      //the root is in (left,right], a root exactly at left belongs to the previous piece
+      if(!((fLeft < 0 && fRight >= 0) || (fLeft > 0 && fRight <= 0)))
+        continue;
+      starts.push_back(range.first);
+      lefts.push_back(fRight == 0 ? points[j+1] : points[j]);
+      rights.push_back(points[j+1]);
+      leftSigns.push_back(fLeft < 0 ? -1 : 1);
+      widths.push_back(h);
+      qa.push_back(q[0]);
+      qb.push_back(q[1]);
+      qc.push_back(q[2]);
+      qd.push_back(q[3]);
+    }
   }
+
+  //refine every bracket at once with Newton's method, falling back to bisection whenever a step would leave the bracket
+  //each iteration is one branch-free pass over the columns, which the compiler can run several brackets at a time
+  int m = starts.size();
+  std::pmr::vector<double> t(m, scratch());
+  for(int k = 0; k < m; k++)
+    t[k] = 0.5*(lefts[k] + rights[k]);
+  for(int iteration = 0; iteration < ROOT_ITERATIONS; iteration++)
+  {
+    int numConverged = 0;
+    for(int k = 0; k < m; k++)
+    {
+      double tk = t[k];
+      double f = ((qd[k]*tk + qc[k])*tk + qb[k])*tk + qa[k];
+      double fPrime = (3*qd[k]*tk + 2*qc[k])*tk + qb[k];
+      //keep the half of the bracket that still changes sign
+      bool exact = f == 0;
+      bool sameSign = f*leftSigns[k] > 0;
+      lefts[k] = (exact || sameSign) ? tk : lefts[k];
+      rights[k] = (exact || !sameSign) ? tk : rights[k];
+      double newton = tk - f/fPrime;
+      bool inside = lefts[k] < newton && newton < rights[k];
+      t[k] = inside ? newton : 0.5*(lefts[k] + rights[k]);
+      double tolerance = ROOT_TOLERANCE*widths[k];
+      numConverged += (rights[k] - lefts[k] <= tolerance) || (fabs(t[k] - tk) <= tolerance);
+    }
+    if(numConverged == m)
+      break;
+  }
+
+  //the brackets were made in order of cubic and then of t, so the roots are already sorted
+  std::vector<double> roots(m);
+  for(int k = 0; k < m; k++)
+    roots[k] = starts[k] + t[k];
   return roots;
 }
 
@@ -79,139 +193,291 @@ double newtonCotes(std::function<double(double)> f, double a, double b, int n)
   return h * (f(a) + 2*sum2 + 4*sum1 + f(b))/3;
 }
 
-//performs Romberg integration over f from a to b
-//computes until the error is less than tolerance or until MAX_ITERATIONS is exceeded, whichever comes first
-double romberg(std::function<double(double)> f, double a, double b, double tolerance)
+//performs Romberg integration over f from a to b, where a <= b
+//computes until the error is less than tolerance or until the table has ROMBERG_MAX_ROWS rows, whichever comes first
+//f is given every new midpoint of a row at once, in ascending order, so a spline can walk through its cubics instead of searching
+double romberg(const batchFunction& f, double a, double b, double tolerance)
 {
   double h = b-a;
-  //we only keep two rows of the extrapolation table in memory at a time
-  std::vector<double> currRow, lastRow;
-  lastRow.push_back(0.5*h*(f(a)+f(b))); //R_1,1
-  for(int i = 2; i <= MAX_ITERATIONS; i++)
+  //we only keep two rows of the extrapolation table, in fixed buffers that trade places after every row
+  double rows[2][ROMBERG_MAX_ROWS];
+  double* lastRow = rows[0];
+  double* currRow = rows[1];
+  //the midpoints of every row and their values share two buffers, which only grow
+  std::pmr::vector<double> xs({a, b}, scratch()), ys(2, scratch());
+  f(xs.data(), 2, ys.data());
+  lastRow[0] = 0.5*h*(ys[0]+ys[1]); //R_1,1
+  int numMidpoints = 1;
+  for(int i = 2; i <= ROMBERG_MAX_ROWS; i++)
   {
-    currRow.clear();
+    xs.resize(numMidpoints);
+    ys.resize(numMidpoints);
+    for(int k = 0; k < numMidpoints; k++)
+      xs[k] = a+(k+0.5)*h;
+    f(xs.data(), numMidpoints, ys.data());
     double sum = 0;
-    for(int k = 1; k <= pow(2,i-2); k++)
-      sum += f(a+(k-0.5)*h); //calculate value in first column of the extrapolation table
-    currRow.push_back(0.5*(lastRow[0] + h*sum));
+    for(double y : ys)
+      sum += y; //calculate value in first column of the extrapolation table
+    currRow[0] = 0.5*(lastRow[0] + h*sum);
     for(int j = 1; j < i; j++)
-      currRow.push_back(currRow[j-1] + (currRow[j-1]-lastRow[j-1])/(pow(4,j)-1)); //perform Richardson extrapolation
+      currRow[j] = currRow[j-1] + (currRow[j-1]-lastRow[j-1])*rombergFactors[j]; //perform Richardson extrapolation
     h *= 0.5; //h halves for each row in the table
-    if(fabs(currRow.back() - lastRow.back()) < tolerance) //estimate error and compare to tolerance
+    numMidpoints *= 2;
+    if(fabs(currRow[i-1] - lastRow[i-2]) < tolerance) //estimate error and compare to tolerance
     {
-      return currRow.back();
+      return currRow[i-1];
     }
-    lastRow = currRow;
+    std::swap(lastRow, currRow);
   }
-  return currRow.back();
+  return lastRow[ROMBERG_MAX_ROWS-1];
 }
 
-//recursively find the integral from a to b with simpson's method
-//tolerance is halved at each recursive level
-double adaptiveQuadhelper(std::function<double(double)> f, double a, double b, double tol, double whole, double f_a, double f_b, double f_mid, int recDepth) {
-    double mid = (a + b)/2;
-    double h = (b - a)/2;
-    double left_mid  = (a + mid)/2;
-    double right_mid  = (mid + b)/2;
-    //check for signs it's not going to converge
-    //if tolerance cannot be halved anymore
-    //or if the average of a and m equals a => a and m are too close together
-    if ((tol/2 == tol) || (a == left_mid))
-      return whole;
-    double f_left_mid = f(left_mid);
-    double f_right_mid = f(right_mid);
-    //simpson's method
-    double left  = (h/6) * (f_a + 4*f_left_mid + f_mid);
-    double right = (h/6) * (f_mid + 4*f_right_mid + f_b);
-    double diff = whole - left - right;
-
-    if (recDepth <= 0 || fabs(diff) <= 10*tol) //10*tolerance is used because that's what is used in the Burden text
-        return left + right;
-    return adaptiveQuadhelper(f, a, mid, tol/2, left,  f_a, f_mid, f_left_mid, recDepth-1) +
-           adaptiveQuadhelper(f, mid, b, tol/2, right, f_mid, f_b, f_right_mid, recDepth-1);
+//one piece of the interval being integrated by adaptiveQuad, with its estimated integral and error
+//pieces are ordered by their error so the worst one is always at the top of the heap
+struct quadInterval
+{
+  double a, b, integral, error;
+
+  bool operator<(const quadInterval& other) const
+  {
+    return error < other.error;
+  }
+};
+
+//integrates f from a to b with a Gauss-Kronrod rule
+//the Gauss rule uses every other Kronrod node, so the difference between the two estimates the error for free
+quadInterval gaussKronrod(const std::function<double(double)>& f, double a, double b, const kronrodRule& rule)
+{
+  double center = (a + b)/2;
+  double halfLength = (b - a)/2;
+  double kronrod = 0, gauss = 0;
+  for(int j = 0; j < rule.nodes.size(); j++)
+  {
+    double value = f(center + halfLength*rule.nodes[j]);
+    kronrod += rule.weights[j]*value;
+    if(j%2 == 1)
+      gauss += rule.gaussWeights[j/2]*value;
+  }
+  return {a, b, kronrod*halfLength, fabs((kronrod - gauss)*halfLength)};
 }
 
-//integrates from a to b until error is less than tolerance
-//performs adaptive quadrature with simpson's rule
-double adaptiveQuad(std::function<double(double)> f, double a, double b, double tolerance)
-{
-    if(a==b)
-      return 0.0;
-    double h = b - a;
-    double f_a = f(a);
-    double f_b = f(b);
-    double f_m = f((a + b)/2);
-    double simpsons = (h/6)*(f_a + 4*f_m + f_b);
-    return adaptiveQuadhelper(f, a, b, tolerance, simpsons, f_a, f_b, f_m, MAX_RECURSION_DEPTH);
+//integrates from a to b until the estimated error is less than tolerance
+//performs adaptive quadrature with the Kronrod extension of the order point Gauss rule
+//instead of recursing with half the tolerance on each side, the pieces are kept in a heap
+//and the one with the largest error is always split next, until the errors of all the pieces add up to less than tolerance
+//breakpoints are points in ascending order where f isn't smooth; the first pieces end at them so no piece has to straddle one
+//the pieces don't share evaluations: Gauss-Kronrod nodes are all inside a piece and don't line up with the nodes of its halves,
+//so splitting a piece evaluates both halves from scratch; the breakpoints are what keeps that rare, since on a single cubic
+//both rules are exact and the first estimate already meets the tolerance
+double adaptiveQuad(const std::function<double(double)>& f, double a, double b, double tolerance, int order, const std::pmr::vector<double>& breakpoints)
+{
+  if(a == b)
+    return 0.0;
+
+  const kronrodRule& rule = getKronrodRule(order);
+
+  std::pmr::vector<quadInterval> heap(scratch());
+  double start = a;
+  for(double x : breakpoints)
+  {
+    if(start < x && x < b)
+    {
+      heap.push_back(gaussKronrod(f, start, x, rule));
+      start = x;
+    }
+  }
+  heap.push_back(gaussKronrod(f, start, b, rule));
+
+  double error = 0;
+  for(auto & piece : heap)
+    error += piece.error;
+  std::make_heap(heap.begin(), heap.end());
+  int maxPieces = heap.size() + MAX_INTERVALS;
+  heap.reserve(maxPieces + 1);
+  while(error > tolerance && heap.size() < maxPieces)
+  {
+    quadInterval worst = heap.front();
+    double mid = (worst.a + worst.b)/2;
+    //the worst piece is too small to split, so the others can't get the error any lower either
+    if(mid <= worst.a || mid >= worst.b)
+      break;
+
+    std::pop_heap(heap.begin(), heap.end());
+    heap.pop_back();
+    quadInterval left = gaussKronrod(f, worst.a, mid, rule);
+    quadInterval right = gaussKronrod(f, mid, worst.b, rule);
+    error += left.error + right.error - worst.error;
+    heap.push_back(left);
+    std::push_heap(heap.begin(), heap.end());
+    heap.push_back(right);
+    std::push_heap(heap.begin(), heap.end());
+  }
+
+  //add the pieces up from scratch instead of keeping a running total, so no rounding error builds up
+  double sum = 0;
+  for(auto & piece : heap)
+    sum += piece.integral;
+  return sum;
 }
 
-//integrates f from a to b using Gaussian Quadrature with n=512
-double gaussQuad(std::function<double(double)> f, double a, double b)
+//integrates the spline from a to b with the order point Gauss-Legendre rule on every piece between its knots
+//each piece is inside one cubic, so it is evaluated with that cubic directly instead of searching for it,
+//and since the rule is exact up to degree 2*order-1, 2 points already integrate each piece exactly
+//evaluations is increased by the number of times a cubic was evaluated
+double gaussQuad(const CubicSpline& spline, double a, double b, int order, int& evaluations)
 {
-    //change of variable from x to t so we can integrate from -1 to 1
-    std::function<double(double)> g = [&](double t){
-      return f(((b-a)*t+b+a)/2)*(b-a)/2;
-    };
-    //the arrays coeff and roots are included from "legendreConstants.h"
-    double sum = 0;
-    for(int i = 0; i < 512; i++)
-      sum += coeff[i]*g(roots[i]);
-    return sum;
+  const quadratureRule& rule = getLegendreRule(order);
+  const double* nodes = rule.nodes.data();
+  const double* weights = rule.weights.data();
+
+  double sum = 0;
+  int first = spline.findIndex(a);
+  int last = spline.findIndex(b);
+  for(int i = first; i <= last; i++)
+  {
+    std::pair<double, double> range = spline.getRange(i);
+    double left = i == first ? a : range.first;
+    double right = i == last ? b : range.second;
+    const FixedPolynomial<3>& q = spline.getLocalCubic(i);
+
+    //change of variable from x to t so we can integrate from -1 to 1, with x measured from the start of the cubic
+    double center = (left + right)/2 - range.first;
+    double halfLength = (right - left)/2;
+    double piece = 0;
+    for(int k = 0; k < order; k++)
+      piece += weights[k]*q.evaluate(center + halfLength*nodes[k]);
+    sum += piece*halfLength;
+  }
+  evaluations += order*(last - first + 1);
+  return sum;
+}
+
+//returns the x-values strictly between a and b where the spline's cubics are stitched together, in ascending order
+std::pmr::vector<double> findKnots(const CubicSpline& spline, double a, double b)
+{
+  std::pmr::vector<double> knots(scratch());
+  for(int i = spline.findIndex(a); i <= spline.findIndex(b); i++)
+  {
+    double x = spline.getRange(i).first;
+    if(a < x && x < b)
+      knots.push_back(x);
+  }
+  return knots;
 }
 
 //integrates a cubic spline from a to b using the specified integration technique
-double integrate(double a, double b, CubicSpline spline, int integrationTechnique, double tolerance)
+//quadratureOrder is the number of points Gaussian quadrature uses on each piece of the spline
+//kronrodOrder is the order of the Gauss rule whose Kronrod extension adaptive quadrature uses
+//if evaluations isn't null, it is set to how many times the spline was evaluated
+double integrate(double a, double b, const CubicSpline& spline, int integrationTechnique, double tolerance, int quadratureOrder, int kronrodOrder, int* evaluations)
 {
-  auto f = [&](double x) { return spline.evaluate(x); };  //lambda for evaluating the spline
+  int count = 0;
+  std::function<double(double)> f = [&](double x) { count++; return spline.evaluate(x); };  //lambda for evaluating the spline
+  batchFunction fBatch = [&](const double* xs, int n, double* ys) { count += n; spline.evaluate(xs, n, ys); };
+  double result = 0;
   switch (integrationTechnique)
   {
-    case 0: //Adaptive
-      return adaptiveQuad(f, a, b, tolerance);
+    case 0: //Adaptive, starting from the pieces between the knots since the spline's third derivative jumps at them
+      result = adaptiveQuad(f, a, b, tolerance, kronrodOrder, findKnots(spline, a, b));
       break;
     case 1: //Romberg
-      return romberg(f, a, b, tolerance);
+      result = romberg(fBatch, a, b, tolerance);
       break;
     case 2: //Composite Newton-Cotes with 20 subintervals
-      return newtonCotes(f, a, b, 20);
+      result = newtonCotes(f, a, b, 20);
       break;
-    case 3: //Gaussian Quadrature
-      return gaussQuad(f, a, b);
+    case 3: //Gaussian Quadrature on each piece of the spline
+      result = gaussQuad(spline, a, b, quadratureOrder, count);
       break;
     default:
-      std::cerr << "Error: integration technique " << integrationTechnique << " is not a valid option" << std::endl;
-      exit(1);
-      break;
+      throw nmrException{NMR_INVALID_OPTION, "integration technique " + std::to_string(integrationTechnique) + " is not a valid option"};
   }
+  if(evaluations)
+    *evaluations = count;
+  return result;
+}
+
+//estimates the standard deviation of the noise from the points below the baseline, where there is no signal
+//the median absolute deviation is used so the tails of peaks that are below the baseline don't inflate it
+//noiseFloor is set to the median of those points
+double estimateNoise(const std::vector<std::pair<double, double>>& data, double& noiseFloor)
+{
+  std::pmr::vector<double> values(scratch());
+  values.reserve(data.size());
+  for(auto & point : data)
+    if(point.second < 0)
+      values.push_back(point.second);
+  noiseFloor = 0;
+  if(values.empty())
+    return 0;
+
+  auto middle = values.begin() + values.size()/2;
+  std::nth_element(values.begin(), middle, values.end());
+  noiseFloor = *middle;
+  for(double & value : values)
+    value = fabs(value - noiseFloor);
+  std::nth_element(values.begin(), middle, values.end());
+  return MAD_SCALE*(*middle);
 }
 
 //calculate a vector of peak structs
-//finds start and endpoints, area, and location
-std::vector<peak> calculatePeaks(CubicSpline spline, int integrationTechnique, double tolerance)
+//finds start and endpoints, area, and location of the peaks between the zero crossings of the spline
+//a candidate peak is only kept if its tallest point is at least minSnr times the noise above the noise floor
+//candidates are dropped before they are integrated, so noise crossings cost almost nothing
+//data are the points the spline was fitted to, from most positive to most negative x
+std::vector<peak> calculatePeaks(CubicSpline spline, const std::vector<std::pair<double, double>>& data, int integrationTechnique, double tolerance, int quadratureOrder, int kronrodOrder, double minSnr)
 {
   //find all the points that the cubic spline intersects the x-axis
   std::vector<double> roots = findRoots(spline);
 
+  double noiseFloor = 0;
+  double noise = minSnr > 0 ? estimateNoise(data, noiseFloor) : 0;
+
   std::vector<peak> peaks; //what we will return
   peaks.reserve(roots.size()/2);
   //each pair of roots will enclose a peak
-  for(int i=0; i < roots.size(); i+=2)
+  //the roots are ascending, so the data points inside them are found by walking the data backwards
+  int next = int(data.size()) - 1;
+  for(int i=0; i+1 < roots.size(); i+=2)
   {
     peak p;
     p.begin = roots[i];
     p.end = roots[i+1];
     p.location = (p.begin + p.end)/2;
+
+    if(minSnr > 0)
+    {
+      double height = spline.evaluate(p.location);
+      while(next >= 0 && data[next].first < p.begin)
+        next--;
+      for(; next >= 0 && data[next].first <= p.end; next--)
+        height = std::max(height, data[next].second);
+      p.snr = noise > 0 ? (height - noiseFloor)/noise : std::numeric_limits<double>::infinity();
+      if(p.snr < minSnr)
+        continue;
+    }
     peaks.push_back(p);
   }
 
-  double minArea = std::numeric_limits<double>::infinity(); //need a value that is bigger than all other values
   //calculate the area of each peak
   for(peak & p : peaks)
   {
-    p.area = integrate(p.begin, p.end, spline, integrationTechnique, tolerance);
+    p.area = integrate(p.begin, p.end, spline, integrationTechnique, tolerance, quadratureOrder, kronrodOrder);
+  }
+
+  return countHydrogens(peaks);
+}
+
+//calculates the number of hydrogens each peak represents
+//the peak with the smallest area is taken to be one hydrogen
+std::vector<peak> countHydrogens(std::vector<peak> peaks)
+{
+  double minArea = std::numeric_limits<double>::infinity(); //need a value that is bigger than all other values
+  for(peak & p : peaks)
+  {
     minArea = std::min(p.area, minArea); //find the smallest area
   }
 
-  //calculate the number of hydrogens each peak represents
   for(peak & p : peaks)
   {
     p.numHydrogens = int(std::round(p.area/minArea));
@@ -219,3 +485,19 @@ std::vector<peak> calculatePeaks(CubicSpline spline, int integrationTechnique, d
 
   return peaks;
 }
+
+//moves every x-value of the peaks left by offset
+//used to put the TMS peak at x=0 once the peaks are found, instead of shifting every data point
+void shiftPeaks(std::vector<peak>& peaks, double offset)
+{
+  for(peak & p : peaks)
+  {
+    p.begin -= offset;
+    p.end -= offset;
+    p.location -= offset;
+    p.leftInflection -= offset;
+    p.rightInflection -= offset;
+    for(lineShape & line : p.lines)
+      line.center -= offset;
+  }
+}
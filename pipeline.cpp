@@ -0,0 +1,180 @@
+//implementation of pipeline.h
+//every file's result goes through the writer, even when reading it failed, so only the writer touches the totals
+//and calls onResult, and the workers never wait on each other for anything
+#include "pipeline.h"
+#include "structs.h"
+#include "prototypes.h"
+#include "nmr.h"
+#include <string>
+#include <vector>
+#include <utility>
+#include <thread>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+
+//how many spectra can wait in each queue for each worker
+#define PIPELINE_QUEUE_PER_WORKER 2
+
+//the number of workers for numThreads, which uses every core when it is 0
+int pipelineWorkers(int numThreads)
+{
+  return numThreads > 0 ? numThreads : std::max(1u, std::thread::hardware_concurrency());
+}
+
+//seconds from start to end
+double secondsBetween(pipelineClock::time_point start, pipelineClock::time_point end)
+{
+  return std::chrono::duration<double>(end - start).count();
+}
+
+//the name of the report for dataFile, which replaces its extension with one for the output format
+std::string reportName(const std::string& dataFile, const std::string& format)
+{
+  size_t slash = dataFile.rfind('/');
+  size_t dot = dataFile.rfind('.');
+  std::string stem = dot != std::string::npos && (slash == std::string::npos || dot > slash) ? dataFile.substr(0, dot) : dataFile;
+  return stem + (format == "json" ? ".json" : format == "csv" ? ".csv" : ".txt");
+}
+
+Pipeline::Pipeline(const configuration& config, std::function<void(const fileResult&)> onResult, pipelineStats& stats)
+  : config(config), onResult(onResult), stats(stats),
+    analyzeQueue(PIPELINE_QUEUE_PER_WORKER*pipelineWorkers(config.numThreads)),
+    writeQueue(PIPELINE_QUEUE_PER_WORKER*pipelineWorkers(config.numThreads)), writeStalls(0), closed(false)
+{
+  //the quadrature rules are made once for the whole run instead of when the first file needs them
+  getLegendreRule(config.quadratureOrder);
+  getKronrodRule(config.kronrodOrder);
+
+  int numWorkers = pipelineWorkers(config.numThreads);
+  stats.queueCapacity = stats.writeQueueCapacity = PIPELINE_QUEUE_PER_WORKER*numWorkers;
+  writer = std::thread(&Pipeline::write, this);
+  for(int i = 0; i < numWorkers; i++)
+    workers.emplace_back(&Pipeline::work, this);
+}
+
+Pipeline::~Pipeline()
+{
+  close();
+}
+
+void Pipeline::add(const std::string& dataFile, pipelineClock::time_point noticed)
+{
+  pipelineJob job;
+  job.noticed = noticed;
+  job.result.dataFile = dataFile;
+  job.result.reportFile = reportName(dataFile, config.format);
+  try
+  {
+    job.data = readData(dataFile);
+  }
+  catch(const nmrException& e)
+  {
+    //a file that can't be read goes straight to the writer, which only reports it
+    job.result.code = e.code;
+    job.result.error = e.message;
+    job.result.readTime = secondsBetween(noticed, pipelineClock::now());
+    writeQueue.push(std::move(job));
+    return;
+  }
+  auto queued = job.queued = pipelineClock::now();
+  job.result.readTime = secondsBetween(noticed, queued);
+
+  bool waited = analyzeQueue.push(std::move(job));
+  auto pushed = pipelineClock::now();
+  stats.maxQueueDepth = std::max(stats.maxQueueDepth, int(analyzeQueue.size()));
+  if(waited)
+  {
+    stats.stalls++;
+    stats.stallTime += secondsBetween(queued, pushed);
+  }
+}
+
+//each worker keeps its own Analyzer, so the memory for its buffers is only allocated for the first file it analyzes
+//the workers already use every thread they were given, so each one sorts and fits on its own thread
+void Pipeline::work()
+{
+  configuration options = config;
+  options.numThreads = 1;
+  Analyzer analyzer;
+  analyzer.configure(options);
+  pipelineJob job;
+  while(analyzeQueue.pop(job))
+  {
+    fileResult& result = job.result;
+    auto start = pipelineClock::now();
+    result.queueTime = secondsBetween(job.queued, start);
+    result.code = analyzer.analyze(job.data, job.peaks, job.shift);
+    job.analyzed = pipelineClock::now();
+    result.analyzeTime = secondsBetween(start, job.analyzed);
+    if(result.code != NMR_OK)
+      result.error = analyzer.lastError();
+    //the spectrum isn't needed any more, so it is freed here instead of waiting in the queue for the writer
+    std::vector<std::pair<double, double>>().swap(job.data);
+    if(writeQueue.push(std::move(job)))
+      writeStalls++;
+  }
+}
+
+void Pipeline::write()
+{
+  configuration options = config;
+  pipelineJob job;
+  while(writeQueue.pop(job))
+  {
+    fileResult& result = job.result;
+    stats.maxWriteQueueDepth = std::max(stats.maxWriteQueueDepth, int(writeQueue.size()) + 1);
+    if(result.code == NMR_OK)
+    {
+      auto start = pipelineClock::now();
+      result.writeQueueTime = secondsBetween(job.analyzed, start);
+      result.numPeaks = job.peaks.size();
+      options.inputFile = result.dataFile;
+      options.outputFile = result.reportFile;
+      try
+      {
+        writeResult(formatResult(job.peaks, options, job.shift, result.analyzeTime), result.reportFile);
+      }
+      catch(const nmrException& e)
+      {
+        result.code = e.code;
+        result.error = e.message;
+      }
+      result.writeTime = secondsBetween(start, pipelineClock::now());
+    }
+
+    result.latency = secondsBetween(job.noticed, pipelineClock::now());
+    if(result.code == NMR_OK)
+      stats.filesDone++;
+    else
+      stats.filesFailed++;
+    stats.totalLatency += result.latency;
+    stats.maxLatency = std::max(stats.maxLatency, result.latency);
+    onResult(result);
+  }
+}
+
+//the workers stop once they have emptied their queue, and only then is the writer's closed,
+//since the workers are the ones pushing into it
+void Pipeline::close()
+{
+  if(closed)
+    return;
+  closed = true;
+  analyzeQueue.close();
+  for(auto & thread : workers)
+    thread.join();
+  writeQueue.close();
+  writer.join();
+  stats.writeStalls = writeStalls;
+}
+
+//analyzes every file in dataFiles with the options in config, writing each report next to its file
+//the files are read on this thread while numThreads workers analyze them and another thread writes the reports
+void analyzeFiles(const configuration& config, const std::vector<std::string>& dataFiles, const std::function<void(const fileResult&)>& onResult, pipelineStats& stats)
+{
+  Pipeline pipeline(config, onResult, stats);
+  for(auto & dataFile : dataFiles)
+    pipeline.add(dataFile, pipelineClock::now());
+  pipeline.close();
+}
@@ -0,0 +1,58 @@
+//class for analyzing many spectra at once in three stages: reading, analyzing and writing the reports
+//the thread that adds files reads them, a pool of workers analyzes them and one writer formats and writes the reports,
+//so parsing the next file and writing the last report overlap with the numerics of the ones in between
+//the stages are joined by bounded lock-free queues, so a stage that gets ahead waits instead of holding every spectrum in memory
+#pragma once
+#include "structs.h"
+#include "queue.h"
+#include <string>
+#include <vector>
+#include <utility>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <functional>
+
+typedef std::chrono::steady_clock pipelineClock;
+
+//a spectrum on its way through the pipeline, with what each stage found
+struct pipelineJob
+{
+  fileResult result;
+  std::vector<std::pair<double, double>> data;
+  std::vector<peak> peaks;
+  double shift = 0;
+  pipelineClock::time_point noticed, queued, analyzed;
+};
+
+class Pipeline
+{
+  private:
+    //the options every file is analyzed with
+    configuration config;
+    std::function<void(const fileResult&)> onResult;
+    pipelineStats& stats;
+    //spectra that have been read and are waiting for a worker, and results waiting for the writer
+    BoundedQueue<pipelineJob> analyzeQueue, writeQueue;
+    std::vector<std::thread> workers;
+    std::thread writer;
+    //how many times a worker had to wait for the writer, counted by every worker
+    std::atomic<int> writeStalls;
+    bool closed;
+
+    //analyzes spectra from analyzeQueue until it is closed and empty, passing the results to the writer
+    void work();
+    //writes the reports of the results in writeQueue until it is closed and empty
+    void write();
+  public:
+    //starts the workers and the writer, with numThreads workers (0 uses every core)
+    //onResult is called once for every file, always from the writer, and stats are kept up to date as files finish
+    Pipeline(const configuration& config, std::function<void(const fileResult&)> onResult, pipelineStats& stats);
+    //closes the pipeline if it hasn't been
+    ~Pipeline();
+    //reads dataFile on the calling thread and passes it to the workers, waiting if they are too far behind
+    //noticed is when the file was found, which its latency is counted from
+    void add(const std::string& dataFile, pipelineClock::time_point noticed);
+    //waits for every file that has been added to be analyzed and written, then stops the workers and the writer
+    void close();
+};
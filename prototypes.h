@@ -1,14 +1,56 @@
 #pragma once
 #include <vector>
+#include <string>
+#include <iosfwd>
+#include <atomic>
+#include <functional>
 #include "structs.h"
 #include "CubicSpline.h"
 
 configuration readConfig(std::string fileName);
-std::vector<std::pair<double, double>> filter(std::vector<std::pair<double, double>> data, int filterType, int filterSize, int numPasses);
+configuration readConfigFile(std::string fileName);
+void validateConfig(const configuration& config);
+void finishConfig(configuration& config);
+void setOption(configuration& config, std::string key, std::string value);
+void readOptions(std::istream& in, configuration& config, std::string fileName);
+void readEnvironment(configuration& config);
+configuration parseOptions(int argc, char* argv[]);
+std::vector<std::pair<double, double>> filter(std::vector<std::pair<double, double>> data, int filterType, int filterSize, int numPasses, int precision = 0);
+std::vector<std::pair<double, double>> boxcarFilter(std::vector<std::pair<double, double>> data, int filterSize, int numPasses, int precision = 0);
+std::vector<std::pair<double, double>> savitzkyGolayFilter(std::vector<std::pair<double, double>> data, int filterSize, int numPasses, int precision = 0);
 std::vector<std::pair<double, double>> readData(std::string fileName);
-std::vector<std::pair<double, double>> baselineAdjustment(std::vector<std::pair<double, double>> data, double baseline, double& shift);
-std::vector<peak> calculatePeaks(CubicSpline c, int integrationTechnique, double tolerance);
-void outputResult(std::vector<peak> peaks, configuration config, double shift, double runtime);
+int findOrder(const std::vector<std::pair<double, double>>& points);
+void parallelSort(std::vector<std::pair<double, double>>& points, int numThreads = 0);
+spectrum orderSpectrum(std::vector<std::pair<double, double>> points, int order, int numThreads = 0);
+void baselineAdjustment(spectrum& data, double baseline, int baselineMode, double& shift);
+std::vector<double> alsBaseline(const std::vector<double>& y);
+void secondDifferencePenalty(int n, std::vector<double>& d0, std::vector<double>& d1, std::vector<double>& d2);
+std::vector<double> polynomialBaseline(const std::vector<double>& x, const std::vector<double>& y);
+bool solveLinearSystem(std::vector<double> A, std::vector<double> b, int n, std::vector<double>& x);
+std::vector<double> findRoots(const CubicSpline& spline, int first = 0, int last = -1);
+const quadratureRule& getLegendreRule(int n);
+const kronrodRule& getKronrodRule(int n);
+double integrate(double a, double b, const CubicSpline& spline, int integrationTechnique, double tolerance, int quadratureOrder, int kronrodOrder, int* evaluations = nullptr);
+int findCriticalPoints(const FixedPolynomial<3>& q, double h, double points[2]);
+std::vector<peak> calculatePeaks(CubicSpline c, const std::vector<std::pair<double, double>>& data, int integrationTechnique, double tolerance, int quadratureOrder, int kronrodOrder, double minSnr);
+double estimateNoise(const std::vector<std::pair<double, double>>& data, double& noiseFloor);
+std::vector<peak> countHydrogens(std::vector<peak> peaks);
+void shiftPeaks(std::vector<peak>& peaks, double offset);
+std::vector<peak> findApexes(std::vector<peak> peaks, const CubicSpline& spline, int peakDetection, int integrationTechnique, double tolerance, int quadratureOrder, int kronrodOrder);
+std::vector<peak> fitPeaks(std::vector<peak> peaks, const std::vector<std::pair<double, double>>& data, int peakModel, int numThreads = 0);
+std::vector<peak> analyze(std::vector<std::pair<double, double>> data, configuration config, double& shift);
+std::string formatResult(std::vector<peak> peaks, configuration config, double shift, double runtime);
+void writeResult(const std::string& result, std::string fileName);
+void analyzeFiles(const configuration& config, const std::vector<std::string>& dataFiles, const std::function<void(const fileResult&)>& onResult, pipelineStats& stats);
+void watchDirectory(const configuration& config, std::string directory, const std::atomic<bool>& stop, const std::function<void(const fileResult&)>& onResult, pipelineStats& stats);
 std::vector<std::pair<double, double>> dftFilter(std::vector<std::pair<double, double>> data);
-void graph(CubicSpline spline, std::vector<std::pair<double,double>> points);
-void graph(std::vector<std::pair<double,double>> points);
+std::vector<std::pair<double, double>> syntheticSpectrum(int numPoints, int numPeaks, double noiseLevel, unsigned seed);
+double exactIntegral(CubicSpline spline, double a, double b);
+std::vector<double> referenceFindRoots(CubicSpline spline);
+std::vector<double> referenceCubicRoots(const CubicSpline& spline);
+double referenceIntegrate(double a, double b, const CubicSpline& spline, int integrationTechnique, double tolerance);
+std::vector<std::pair<double, double>> referenceDftFilter(std::vector<std::pair<double, double>> data);
+std::string renderGraph(const std::vector<std::pair<double,double>>& points, const CubicSpline* spline, const std::vector<peak>& peaks);
+void graph(std::vector<std::pair<double,double>> points, std::string fileName);
+void graph(CubicSpline spline, std::vector<std::pair<double,double>> points, std::string fileName);
+void graph(CubicSpline spline, std::vector<std::pair<double,double>> points, std::vector<peak> peaks, std::string fileName);
@@ -0,0 +1,275 @@
+//a registry of Gauss-Legendre and Gauss-Kronrod rules of any order
+//each rule is generated the first time it is asked for and kept for the rest of the run
+//Gauss-Legendre rules up to MAX_LEGENDRE_ORDER are copied from the tables generated at compile time
+#include "structs.h"
+#include "prototypes.h"
+#include "gaussLegendre.h"
+#include <vector>
+#include <map>
+#include <mutex>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <string>
+
+//QL iteration gives up on an eigenvalue after this many steps
+#define QL_ITERATIONS 60
+
+//scales s and t by the same power of two so the largest of them is about 1
+//the recurrence is linear in them and only their ratios are used, so this changes nothing but stops them
+//underflowing, which they otherwise do for n above about 530 since each step shrinks them by about 4
+void rescaleLaurie(std::vector<double>& s, std::vector<double>& t)
+{
+  double largest = 0;
+  for(int i = 0; i < s.size(); i++)
+    largest = std::max(largest, std::max(fabs(s[i]), fabs(t[i])));
+  if(largest == 0 || !std::isfinite(largest))
+    return;
+  int exponent = std::ilogb(largest);
+  for(int i = 0; i < s.size(); i++)
+  {
+    s[i] = std::ldexp(s[i], -exponent);
+    t[i] = std::ldexp(t[i], -exponent);
+  }
+}
+
+//generates the n point Gauss-Legendre rule with Newton's method, the same way as makeLegendreRule
+quadratureRule generateLegendreRule(int n)
+{
+  quadratureRule rule;
+  rule.nodes.resize(n);
+  rule.weights.resize(n);
+  for(int i = 0; i < (n+1)/2; i++)
+  {
+    double x = cos(LEGENDRE_PI*(i + 0.75)/(n + 0.5));
+    double derivative = 0;
+    for(int iteration = 0; iteration < LEGENDRE_ITERATIONS; iteration++)
+    {
+      double step = legendre(n, x, derivative)/derivative;
+      x -= step;
+      if(fabs(step) < LEGENDRE_TOLERANCE)
+        break;
+    }
+    legendre(n, x, derivative);
+    double weight = 2/((1 - x*x)*derivative*derivative);
+    rule.nodes[i] = -x;
+    rule.nodes[n-1-i] = x;
+    rule.weights[i] = weight;
+    rule.weights[n-1-i] = weight;
+  }
+  if(n%2 == 1)
+    rule.nodes[n/2] = 0;
+  return rule;
+}
+
+//finds the eigenvalues of the symmetric tridiagonal matrix with diagonal d and off diagonal e with the implicit QL method
+//d is replaced by the eigenvalues and first is set to the first component of each normalized eigenvector
+//only the first row of the eigenvector matrix is needed, so only it is rotated
+void tridiagonalEigen(std::vector<double>& d, std::vector<double> e, std::vector<double>& first)
+{
+  int n = d.size();
+  e.resize(n, 0.0);
+  first.assign(n, 0.0);
+  first[0] = 1;
+
+  for(int l = 0; l < n; l++)
+  {
+    int m;
+    for(int iteration = 0; iteration <= QL_ITERATIONS; iteration++)
+    {
+      //look for a small off diagonal element to split the matrix at
+      for(m = l; m < n-1; m++)
+        if(fabs(e[m]) <= std::numeric_limits<double>::epsilon()*(fabs(d[m]) + fabs(d[m+1])))
+          break;
+      if(m == l)
+        break;
+
+      double g = (d[l+1] - d[l])/(2*e[l]);
+      double r = hypot(g, 1.0);
+      g = d[m] - d[l] + e[l]/(g + copysign(r, g));
+      double s = 1, c = 1, p = 0;
+      int i;
+      for(i = m-1; i >= l; i--)
+      {
+        double f = s*e[i];
+        double b = c*e[i];
+        r = hypot(f, g);
+        e[i+1] = r;
+        if(r == 0)
+        {
+          d[i+1] -= p;
+          e[m] = 0;
+          break;
+        }
+        s = f/r;
+        c = g/r;
+        g = d[i+1] - p;
+        r = (d[i] - g)*s + 2*c*b;
+        p = s*r;
+        d[i+1] = g + p;
+        g = c*r - b;
+        f = first[i+1];
+        first[i+1] = s*first[i] + c*f;
+        first[i] = c*first[i] - s*f;
+      }
+      if(r == 0 && i >= l)
+        continue;
+      d[l] -= p;
+      e[l] = g;
+      e[m] = 0;
+    }
+  }
+}
+
+//generates the 2n+1 point Kronrod extension of the n point Gauss-Legendre rule
+//Laurie's algorithm finds the Jacobi matrix of the Kronrod rule from the Legendre recurrence,
+//and its eigenvalues and eigenvectors are the nodes and weights (the Golub-Welsch method)
+kronrodRule generateKronrodRule(int n)
+{
+  //the recurrence coefficients of the monic Legendre polynomials, indexed from 1 like Laurie's paper
+  //a is always 0 and b_1 is the integral of the weight function, and only the first ceil(3n/2)+1 are needed
+  std::vector<double> a(2*n+3, 0.0), b(2*n+3, 0.0);
+  for(int k = 0; k <= (3*n+1)/2 && k <= 2*n; k++)
+    b[k+1] = k == 0 ? 2 : double(k)*k/(4.0*k*k - 1);
+
+  std::vector<double> s(n/2 + 3, 0.0), t(n/2 + 3, 0.0);
+  t[2] = b[n+2];
+  for(int m = 0; m <= n-2; m++)
+  {
+    double u = 0;
+    for(int k = (m+1)/2; k >= 0; k--)
+    {
+      int l = m - k;
+      u += (a[k+n+2] - a[l+1])*t[k+2] + b[k+n+2]*s[k+1] - b[l+1]*s[k+2];
+      s[k+2] = u;
+    }
+    std::swap(s, t);
+    rescaleLaurie(s, t);
+  }
+  for(int j = n/2; j >= 0; j--)
+    s[j+2] = s[j+1];
+  for(int m = n-1; m <= 2*n-3; m++)
+  {
+    double u = 0;
+    int j = 0;
+    for(int k = m+1-n; k <= (m-1)/2; k++)
+    {
+      int l = m - k;
+      j = n-1-l;
+      u += -(a[k+n+2] - a[l+1])*t[j+2] - b[k+n+2]*s[j+2] + b[l+1]*s[j+3];
+      s[j+2] = u;
+    }
+    if(m%2 == 0)
+    {
+      int k = m/2;
+      a[k+n+2] = a[k+1] + (s[j+2] - b[k+n+2]*s[j+3])/t[j+3];
+    }
+    else
+    {
+      int k = (m+1)/2;
+      b[k+n+2] = s[j+2]/s[j+3];
+    }
+    std::swap(s, t);
+    rescaleLaurie(s, t);
+  }
+  a[2*n+1] = a[n] - b[2*n+1]*s[2]/t[2];
+
+  //the Jacobi matrix of the Kronrod rule
+  std::vector<double> d(2*n+1), e(2*n);
+  for(int k = 0; k < 2*n+1; k++)
+    d[k] = a[k+1];
+  for(int k = 0; k < 2*n; k++)
+  {
+    if(b[k+2] < 0)
+      throw nmrException{NMR_NUMERICAL, "the " + std::to_string(n) + " point Gauss-Legendre rule has no real Kronrod extension"};
+    e[k] = sqrt(b[k+2]);
+  }
+  std::vector<double> first;
+  tridiagonalEigen(d, e, first);
+
+  //sort the nodes into ascending order, so the Gauss nodes are the odd ones
+  std::vector<int> order(2*n+1);
+  for(int i = 0; i < order.size(); i++)
+    order[i] = i;
+  std::sort(order.begin(), order.end(), [&](int i, int j){ return d[i] < d[j]; });
+
+  kronrodRule rule;
+  for(int i : order)
+  {
+    rule.nodes.push_back(d[i]);
+    rule.weights.push_back(b[1]*first[i]*first[i]);
+  }
+  //the rule is symmetric, so average each pair of nodes to get rid of rounding error
+  for(int i = 0; i < n; i++)
+  {
+    double x = (rule.nodes[2*n-i] - rule.nodes[i])/2;
+    double w = (rule.weights[2*n-i] + rule.weights[i])/2;
+    rule.nodes[i] = -x;
+    rule.nodes[2*n-i] = x;
+    rule.weights[i] = w;
+    rule.weights[2*n-i] = w;
+  }
+  rule.nodes[n] = 0;
+  //the Gauss nodes are taken from the Gauss rule itself, so both estimates use exactly the same points
+  const quadratureRule& gauss = getLegendreRule(n);
+  for(int j = 0; j < n; j++)
+    rule.nodes[2*j+1] = gauss.nodes[j];
+  rule.gaussWeights = gauss.weights;
+  return rule;
+}
+
+//returns the n point Gauss-Legendre rule on [-1,1], with its nodes in ascending order
+//safe to call from multiple threads
+const quadratureRule& getLegendreRule(int n)
+{
+  static std::map<int, quadratureRule> rules;
+  static std::mutex lock;
+  std::lock_guard<std::mutex> guard(lock);
+
+  auto found = rules.find(n);
+  if(found != rules.end())
+    return found->second;
+
+  quadratureRule rule;
+  const double* nodes;
+  const double* weights;
+  if(findLegendreRule(n, nodes, weights))
+  {
+    rule.nodes.assign(nodes, nodes + n);
+    rule.weights.assign(weights, weights + n);
+  }
+  else
+    rule = generateLegendreRule(n);
+  return rules[n] = rule;
+}
+
+//throws if rule isn't a usable Kronrod rule: every node and weight has to be finite,
+//the nodes strictly increasing inside [-1,1] and the weights, including the Gauss ones, positive
+void checkKronrodRule(const kronrodRule& rule, int n)
+{
+  bool valid = rule.nodes.size() == 2*n+1 && rule.weights.size() == 2*n+1 && rule.gaussWeights.size() == n;
+  for(int i = 0; valid && i < rule.nodes.size(); i++)
+    valid = std::isfinite(rule.nodes[i]) && std::isfinite(rule.weights[i]) && rule.weights[i] > 0 &&
+            rule.nodes[i] > -1 && rule.nodes[i] < 1 && (i == 0 || rule.nodes[i] > rule.nodes[i-1]);
+  for(int j = 0; valid && j < n; j++)
+    valid = std::isfinite(rule.gaussWeights[j]) && rule.gaussWeights[j] > 0;
+  if(!valid)
+    throw nmrException{NMR_NUMERICAL, "could not generate the " + std::to_string(2*n+1) + " point Gauss-Kronrod rule"};
+}
+
+//returns the 2n+1 point Kronrod extension of the n point Gauss-Legendre rule on [-1,1]
+//its nodes are in ascending order, and the Gauss nodes are the odd ones
+//safe to call from multiple threads
+const kronrodRule& getKronrodRule(int n)
+{
+  static std::map<int, kronrodRule> rules;
+  static std::mutex lock;
+  std::lock_guard<std::mutex> guard(lock);
+
+  auto found = rules.find(n);
+  if(found != rules.end())
+    return found->second;
+  kronrodRule rule = generateKronrodRule(n);
+  checkKronrodRule(rule, n);
+  return rules[n] = rule;
+}
@@ -0,0 +1,156 @@
+//a first in, first out queue with a fixed capacity, for handing work from one stage of a pipeline to the next
+//it is lock-free: each slot has a sequence number that says whether it is ready to be written or read,
+//so producers and consumers only race on an atomic counter instead of sharing a mutex
+//a producer that gets ahead of its consumers waits for them instead of letting the queue grow without bound
+#pragma once
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <cstddef>
+#include <algorithm>
+
+//how many times a thread that can't push or pop yields before it starts sleeping between tries
+#define QUEUE_SPINS 64
+//how long it sleeps after that, in microseconds, which doubles with every try up to the longest sleep
+#define QUEUE_SLEEP_MICROSECONDS 50
+#define QUEUE_MAX_SLEEP_MICROSECONDS 2000
+
+template <typename T>
+class BoundedQueue
+{
+  private:
+    struct slot
+    {
+      //equal to the position that can be pushed into this slot when it is empty, and one more than it once it is full
+      std::atomic<std::size_t> sequence;
+      T item;
+    };
+    std::unique_ptr<slot[]> slots;
+    //the capacity is rounded up to a power of two, so a position's slot is its low bits
+    std::size_t mask;
+    //the next positions to push into and pop from, on separate cache lines so producers and consumers don't share one
+    alignas(64) std::atomic<std::size_t> tail;
+    alignas(64) std::atomic<std::size_t> head;
+    //once the queue is closed nothing more should be pushed, and pop returns false when it is empty
+    std::atomic<bool> closed;
+
+    //yields for the first few tries and then sleeps for longer and longer,
+    //so a thread waiting on a slow stage hardly takes any time from the threads doing the work
+    static void backoff(int& tries)
+    {
+      if(tries < QUEUE_SPINS)
+        std::this_thread::yield();
+      else
+      {
+        int doublings = std::min(tries - QUEUE_SPINS, 16);
+        long sleep = std::min(long(QUEUE_SLEEP_MICROSECONDS) << doublings, long(QUEUE_MAX_SLEEP_MICROSECONDS));
+        std::this_thread::sleep_for(std::chrono::microseconds(sleep));
+      }
+      tries++;
+    }
+  public:
+    BoundedQueue(std::size_t capacity) : tail(0), head(0), closed(false)
+    {
+      std::size_t size = 1;
+      while(size < capacity)
+        size *= 2;
+      slots = std::make_unique<slot[]>(size);
+      mask = size - 1;
+      for(std::size_t i = 0; i < size; i++)
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    //adds item to the back of the queue if there is room, and returns whether there was
+    bool tryPush(T& item)
+    {
+      std::size_t position = tail.load(std::memory_order_relaxed);
+      slot* s;
+      while(true)
+      {
+        s = &slots[position & mask];
+        std::size_t sequence = s->sequence.load(std::memory_order_acquire);
+        std::ptrdiff_t difference = std::ptrdiff_t(sequence) - std::ptrdiff_t(position);
+        if(difference == 0)
+        {
+          if(tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            break;
+        }
+        //the slot still holds the item pushed one lap ago, so the queue is full
+        else if(difference < 0)
+          return false;
+        else
+          position = tail.load(std::memory_order_relaxed);
+      }
+      s->item = std::move(item);
+      s->sequence.store(position + 1, std::memory_order_release);
+      return true;
+    }
+
+    //takes the item at the front of the queue if there is one, and returns whether there was
+    bool tryPop(T& item)
+    {
+      std::size_t position = head.load(std::memory_order_relaxed);
+      slot* s;
+      while(true)
+      {
+        s = &slots[position & mask];
+        std::size_t sequence = s->sequence.load(std::memory_order_acquire);
+        std::ptrdiff_t difference = std::ptrdiff_t(sequence) - std::ptrdiff_t(position + 1);
+        if(difference == 0)
+        {
+          if(head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            break;
+        }
+        //nothing has been pushed into this slot yet, so the queue is empty
+        else if(difference < 0)
+          return false;
+        else
+          position = head.load(std::memory_order_relaxed);
+      }
+      item = std::move(s->item);
+      //the slot is free for the push one lap after this one
+      s->sequence.store(position + mask + 1, std::memory_order_release);
+      return true;
+    }
+
+    //adds item to the back of the queue, waiting while it is full
+    //returns true if it had to wait, so the producer can tell how often its consumers hold it back
+    bool push(T item)
+    {
+      int tries = 0;
+      while(!tryPush(item))
+        backoff(tries);
+      return tries > 0;
+    }
+
+    //takes the item at the front of the queue, waiting while it is empty
+    //returns false if the queue is closed and has nothing left in it
+    bool pop(T& item)
+    {
+      int tries = 0;
+      while(!tryPop(item))
+      {
+        //everything pushed before the queue was closed is visible once closed is, so one more try finds anything left
+        if(closed.load(std::memory_order_acquire))
+          return tryPop(item);
+        backoff(tries);
+      }
+      return true;
+    }
+
+    //tells the consumers that nothing more will be pushed, so they stop once the queue is empty
+    //it is called after every producer has finished pushing
+    void close()
+    {
+      closed.store(true, std::memory_order_release);
+    }
+
+    //about how many items are waiting in the queue, exact when nothing is pushing or popping
+    std::size_t size() const
+    {
+      std::size_t pushed = tail.load(std::memory_order_acquire);
+      std::size_t popped = head.load(std::memory_order_acquire);
+      return pushed > popped ? pushed - popped : 0;
+    }
+};
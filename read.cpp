@@ -1,12 +1,88 @@
 //functions for reading in files
 #include "structs.h"
+#include "prototypes.h"
+#include "gaussLegendre.h"
 #include <fstream>
-#include <iostream>
+#include <sstream>
+#include <string>
 #include <vector>
 #include <limits>
 
-//reads in the configuration file and returns all the options in a struct
-configuration readConfig(std::string fileName)
+//throws an invalid option error for an option whose value is out of range
+template <typename T>
+void invalidOption(std::string name, T value, std::string allowed = "")
+{
+  std::stringstream message;
+  message << name << " " << value << " is not valid" << allowed << ".";
+  throw nmrException{NMR_INVALID_OPTION, message.str()};
+}
+
+//checks that every option in config is in range, and throws an invalid option error for the first one that isn't
+void validateConfig(const configuration& config)
+{
+  if(config.tolerance <= 0)
+    invalidOption("tolerance", config.tolerance);
+  if(config.filterType < 0 || config.filterType > 3)
+    invalidOption("filter type", config.filterType);
+  if(config.filterSize < 0 || ((config.filterType == 1 || config.filterType == 2) && config.filterSize % 2 == 0))
+    invalidOption("filter size", config.filterSize, ", it must be odd");
+  if(config.filterType == 2 && config.filterSize != 5 && config.filterSize != 11 && config.filterSize != 17)
+    invalidOption("Savitzky-Golay filter size", config.filterSize, ", it must be 5, 11 or 17");
+  if(config.numPasses < 0)
+    invalidOption("number of filter passes", config.numPasses);
+  if(config.integrationTechnique < 0 || config.integrationTechnique > 3)
+    invalidOption("integration technique", config.integrationTechnique);
+  if(config.peakModel < 0 || config.peakModel > 3)
+    invalidOption("peak fitting model", config.peakModel);
+  if(config.peakDetection < 0 || config.peakDetection > 2)
+    invalidOption("peak detection method", config.peakDetection);
+  if(config.baselineMode < 0 || config.baselineMode > 2)
+    invalidOption("baseline correction", config.baselineMode);
+  if(config.minSnr < 0)
+    invalidOption("minimum signal to noise ratio", config.minSnr);
+  if(config.quadratureOrder < 1 || config.quadratureOrder > MAX_QUADRATURE_ORDER)
+    invalidOption("Gaussian quadrature order", config.quadratureOrder, ", it must be between 1 and " + std::to_string(MAX_QUADRATURE_ORDER));
+  if(config.kronrodOrder < 1 || config.kronrodOrder > MAX_QUADRATURE_ORDER)
+    invalidOption("Gauss-Kronrod order", config.kronrodOrder, ", it must be between 1 and " + std::to_string(MAX_QUADRATURE_ORDER));
+  if(config.precision < 0 || config.precision > 1)
+    invalidOption("precision", config.precision);
+  if(config.numThreads < 0)
+    invalidOption("number of threads", config.numThreads);
+  if(config.format != "" && config.format != "text" && config.format != "json" && config.format != "csv")
+    invalidOption("output format", config.format, ", it must be text, json or csv");
+}
+
+//applies the options that change the meaning of others
+void finishConfig(configuration& config)
+{
+  //a filter size of zero means no filtering
+  if(config.filterSize == 0 &&  config.filterType != 3)
+    config.filterType = 0;
+}
+
+//returns true if the first line of in that isn't blank or a comment is a key=value line
+//in is rewound to its start afterwards
+bool isKeyValueFormat(std::istream& in)
+{
+  std::string line;
+  bool keyValue = false;
+  while(std::getline(in, line))
+  {
+    line = line.substr(0, line.find('#'));
+    if(line.find_first_not_of(" \t\r") == std::string::npos)
+      continue;
+    keyValue = line.find('=') != std::string::npos;
+    break;
+  }
+  in.clear();
+  in.seekg(0);
+  return keyValue;
+}
+
+//reads in the options from a configuration file without checking them
+//the file is either eight or more positional lines like nmr.in, or key=value lines in any order
+//options the file leaves out keep their default values
+configuration readConfigFile(std::string fileName)
 {
   //data type we're going to return
   configuration result;
@@ -14,6 +90,13 @@ configuration readConfig(std::string fileName)
   auto max = std::numeric_limits<std::streamsize>::max();
 
   std::ifstream configFile(fileName);
+  if(!configFile)
+    throw nmrException{NMR_CONFIG_FILE, "could not read configuration file " + fileName};
+  if(isKeyValueFormat(configFile))
+  {
+    readOptions(configFile, result, fileName);
+    return result;
+  }
 
   configFile >> result.inputFile;
   configFile.ignore(max, '\n'); //ignore the rest of the line
@@ -32,28 +115,64 @@ configuration readConfig(std::string fileName)
   configFile >> result.outputFile;
 
   if(!configFile)
-  {
-    std::cerr << "Error reading in configuration file " << fileName << std::endl;
-    exit(1);
-  }
+    throw nmrException{NMR_CONFIG_FILE, "could not read configuration file " + fileName};
 
-  //a filter size of zero means no filtering
-  if(result.filterSize == 0 &&  result.filterType != 3)
-    result.filterType = 0;
+  //the rest of the lines are optional, and take their default value if they are missing
+  //peak fitting model
+  configFile.ignore(max, '\n');
+  if(!(configFile >> result.peakModel))
+    result.peakModel = 0;
+
+  //peak detection method
+  configFile.ignore(max, '\n');
+  if(!(configFile >> result.peakDetection))
+    result.peakDetection = 0;
+
+  //baseline correction
+  configFile.ignore(max, '\n');
+  if(!(configFile >> result.baselineMode))
+    result.baselineMode = 0;
+
+  //minimum signal to noise ratio of a peak
+  configFile.ignore(max, '\n');
+  if(!(configFile >> result.minSnr))
+    result.minSnr = 0;
+
+  //number of points Gaussian quadrature uses on each piece of the spline
+  configFile.ignore(max, '\n');
+  if(!(configFile >> result.quadratureOrder))
+    result.quadratureOrder = 2;
+
+  //order of the Gauss rule whose Kronrod extension adaptive quadrature uses
+  configFile.ignore(max, '\n');
+  if(!(configFile >> result.kronrodOrder))
+    result.kronrodOrder = 7;
+
+  //precision the filters work in
+  configFile.ignore(max, '\n');
+  if(!(configFile >> result.precision))
+    result.precision = 0;
 
   return result;
 }
 
+//reads in the configuration file and returns all the options in a struct
+//throws an error if the file can't be read or an option is out of range
+configuration readConfig(std::string fileName)
+{
+  configuration result = readConfigFile(fileName);
+  finishConfig(result);
+  validateConfig(result);
+  return result;
+}
+
 
 //reads in the data and stores it in a vector of pairs
 std::vector<std::pair<double, double>> readData(std::string fileName)
 {
   std::ifstream file(fileName.c_str());
   if(!file)
-  {
-    std::cerr << "Error reading data file" << std::endl;
-    exit(1);
-  }
+    throw nmrException{NMR_DATA_FILE, "could not read data file " + fileName};
 
   std::vector<std::pair<double, double>> data;
   double x, y;
@@ -0,0 +1,274 @@
+//reference implementations that the regression tests use as oracles for the faster code paths
+#include "CubicSpline.h"
+#include <vector>
+#include <utility>
+#include <complex>
+#include <functional>
+#include <algorithm>
+#include <cmath>
+
+//integrates a cubic spline from a to b exactly by integrating each of its local cubics analytically
+double exactIntegral(CubicSpline spline, double a, double b)
+{
+  double sum = 0;
+  for(int i = 0; i < spline.getNumCubics(); i++)
+  {
+    std::pair<double, double> range = spline.getRange(i);
+    //the part of [a,b] that this cubic is valid over
+    double left = std::max(a, range.first);
+    double right = std::min(b, range.second);
+    if(left >= right)
+      continue;
+
+    //integrate each term with the power rule, measuring t from the start of the range
+    FixedPolynomial<3> q = spline.getLocalCubic(i);
+    double tLeft = left - range.first;
+    double tRight = right - range.first;
+    for(int k = 0; k <= q.getDegree(); k++)
+      sum += q[k]*(pow(tRight, k+1) - pow(tLeft, k+1))/(k+1);
+  }
+  return sum;
+}
+
+//finds all the x-values at which the cubic spline intersects the x-axis by brute force
+//each local cubic is sampled at REFERENCE_ROOT_SAMPLES points and every sign change between samples is bisected
+#define REFERENCE_ROOT_SAMPLES 32
+std::vector<double> referenceFindRoots(CubicSpline spline)
+{
+  std::vector<double> roots;
+  for(int i = 0; i < spline.getNumCubics(); i++)
+  {
+    FixedPolynomial<3> p = spline.getLocalCubic(i);
+    std::pair<double, double> range = spline.getRange(i);
+    double h = (range.second - range.first)/REFERENCE_ROOT_SAMPLES;
+    for(int j = 0; j < REFERENCE_ROOT_SAMPLES; j++)
+    {
+      //look for a root in (left,right], measured from the start of the range
+      double left = j*h;
+      double right = j+1 == REFERENCE_ROOT_SAMPLES ? range.second - range.first : left + h;
+      double fLeft = p.evaluate(left);
+      double fRight = p.evaluate(right);
+      if(!((fLeft < 0 && fRight >= 0) || (fLeft > 0 && fRight <= 0)))
+        continue;
+      while(true)
+      {
+        double mid = (left + right)/2;
+        if(mid <= left || mid >= right)
+          break;
+        if((p.evaluate(mid) < 0) == (fLeft < 0))
+          left = mid;
+        else
+          right = mid;
+      }
+      roots.push_back(range.first + right);
+    }
+  }
+  return roots;
+}
+
+//the routines below are the ones the analysis started with, kept as oracles for the code that replaced them
+//only what they depended on has changed: the cubic solver of the GSL and the matrices of Armadillo are written out here
+namespace baseline
+{
+#include "legendreConstants.h"
+}
+
+#define BASELINE_MAX_ITERATIONS 1000
+#define BASELINE_MAX_RECURSION_DEPTH 10
+
+//solves x^3 + ax^2 + bx + c = 0 in closed form, as gsl_poly_solve_cubic does
+//returns how many real roots there are, in ascending order in x0, x1, x2
+int solveCubic(double a, double b, double c, double& x0, double& x1, double& x2)
+{
+  double q = a*a - 3*b;
+  double r = 2*a*a*a - 9*a*b + 27*c;
+  double Q = q/9;
+  double R = r/54;
+  double Q3 = Q*Q*Q;
+  double R2 = R*R;
+  double CR2 = 729*r*r;
+  double CQ3 = 2916*q*q*q;
+  if(R == 0 && Q == 0)
+  {
+    x0 = x1 = x2 = -a/3;
+    return 3;
+  }
+  if(CR2 == CQ3)
+  {
+    //a double root and a single root
+    double sqrtQ = sqrt(Q);
+    if(R > 0)
+    {
+      x0 = -2*sqrtQ - a/3;
+      x1 = x2 = sqrtQ - a/3;
+    }
+    else
+    {
+      x0 = x1 = -sqrtQ - a/3;
+      x2 = 2*sqrtQ - a/3;
+    }
+    return 3;
+  }
+  if(R2 < Q3)
+  {
+    //three real roots, found with the trigonometric method
+    double ratio = (R >= 0 ? 1 : -1)*sqrt(R2/Q3);
+    double theta = acos(ratio);
+    double norm = -2*sqrt(Q);
+    double roots[3] = {norm*cos(theta/3) - a/3, norm*cos((theta + 2*M_PI)/3) - a/3, norm*cos((theta - 2*M_PI)/3) - a/3};
+    std::sort(roots, roots + 3);
+    x0 = roots[0];
+    x1 = roots[1];
+    x2 = roots[2];
+    return 3;
+  }
+  double A = -(R >= 0 ? 1 : -1)*pow(fabs(R) + sqrt(R2 - Q3), 1.0/3.0);
+  double B = Q/A;
+  x0 = A + B - a/3;
+  return 1;
+}
+
+//finds the roots of every cubic of the spline in closed form, the way findRoots did before it used local cubics
+std::vector<double> referenceCubicRoots(const CubicSpline& spline)
+{
+  std::vector<double> roots;
+  for(int i = 0; i < spline.getNumCubics(); i++)
+  {
+    const FixedPolynomial<3>& p = spline[i];
+    std::pair<double, double> range = spline.getRange(i);
+    double x[3];
+    int numRoots = solveCubic(p[2]/p[3], p[1]/p[3], p[0]/p[3], x[0], x[1], x[2]);
+    //a root that appears twice is only counted once, since the spline only touches zero there
+    for(int j = 0; j < numRoots; j++)
+      if(range.first < x[j] && x[j] <= range.second && (j == 0 || x[j] != x[j-1]))
+        roots.push_back(x[j]);
+  }
+  return roots;
+}
+
+//integrates f from a to b using composite Newton-Cotes with Simpson's rule on n subdivisions, n must be even
+double baselineNewtonCotes(std::function<double(double)> f, double a, double b, int n)
+{
+  double h = (b-a)/n;
+  double sum1 = 0;
+  double sum2 = 0;
+  for(int i = 1; i < n; i++)
+  {
+    double x = a + i*h;
+    if(i%2==0)
+      sum2 += f(x);
+    else
+      sum1 += f(x);
+  }
+  return h * (f(a) + 2*sum2 + 4*sum1 + f(b))/3;
+}
+
+//Romberg integration of f from a to b, until two rows agree to within tolerance
+double baselineRomberg(std::function<double(double)> f, double a, double b, double tolerance)
+{
+  double h = b-a;
+  std::vector<double> currRow, lastRow;
+  lastRow.push_back(0.5*h*(f(a)+f(b)));
+  for(int i = 2; i <= BASELINE_MAX_ITERATIONS; i++)
+  {
+    currRow.clear();
+    double sum = 0;
+    for(int k = 1; k <= pow(2,i-2); k++)
+      sum += f(a+(k-0.5)*h);
+    currRow.push_back(0.5*(lastRow[0] + h*sum));
+    for(int j = 1; j < i; j++)
+      currRow.push_back(currRow[j-1] + (currRow[j-1]-lastRow[j-1])/(pow(4,j)-1));
+    h *= 0.5;
+    if(fabs(currRow.back() - lastRow.back()) < tolerance)
+      return currRow.back();
+    lastRow = currRow;
+  }
+  return currRow.back();
+}
+
+//one level of recursive adaptive Simpson's method, with the tolerance halved at each level
+double baselineAdaptiveHelper(std::function<double(double)> f, double a, double b, double tol, double whole, double f_a, double f_b, double f_mid, int recDepth)
+{
+  double mid = (a + b)/2;
+  double h = (b - a)/2;
+  double left_mid = (a + mid)/2;
+  double right_mid = (mid + b)/2;
+  if((tol/2 == tol) || (a == left_mid))
+    return whole;
+  double f_left_mid = f(left_mid);
+  double f_right_mid = f(right_mid);
+  double left = (h/6) * (f_a + 4*f_left_mid + f_mid);
+  double right = (h/6) * (f_mid + 4*f_right_mid + f_b);
+  double diff = whole - left - right;
+  if(recDepth <= 0 || fabs(diff) <= 10*tol)
+    return left + right;
+  return baselineAdaptiveHelper(f, a, mid, tol/2, left, f_a, f_mid, f_left_mid, recDepth-1) +
+         baselineAdaptiveHelper(f, mid, b, tol/2, right, f_mid, f_b, f_right_mid, recDepth-1);
+}
+
+//adaptive quadrature with Simpson's rule from a to b
+double baselineAdaptiveQuad(std::function<double(double)> f, double a, double b, double tolerance)
+{
+  if(a==b)
+    return 0.0;
+  double h = b - a;
+  double f_a = f(a);
+  double f_b = f(b);
+  double f_m = f((a + b)/2);
+  double simpsons = (h/6)*(f_a + 4*f_m + f_b);
+  return baselineAdaptiveHelper(f, a, b, tolerance, simpsons, f_a, f_b, f_m, BASELINE_MAX_RECURSION_DEPTH);
+}
+
+//Gauss-Legendre quadrature of f from a to b with the 512 point rule in legendreConstants.h
+double baselineGaussQuad(std::function<double(double)> f, double a, double b)
+{
+  double sum = 0;
+  for(int i = 0; i < 512; i++)
+    sum += baseline::coeff[i]*f(((b-a)*baseline::roots[i]+b+a)/2)*(b-a)/2;
+  return sum;
+}
+
+//integrates the spline from a to b with the original implementation of integrationTechnique
+double referenceIntegrate(double a, double b, const CubicSpline& spline, int integrationTechnique, double tolerance)
+{
+  auto f = [&](double x) { return spline.evaluate(x); };
+  switch(integrationTechnique)
+  {
+    case 0:
+      return baselineAdaptiveQuad(f, a, b, tolerance);
+    case 1:
+      return baselineRomberg(f, a, b, tolerance);
+    case 2:
+      return baselineNewtonCotes(f, a, b, 20);
+    default:
+      return baselineGaussQuad(f, a, b);
+  }
+}
+
+//the discrete Fourier transform filter as a dense matrix product: the intensities are transformed by Z,
+//damped by the diagonal matrix G and transformed back by the conjugate of Z, which takes O(n^2) time
+std::vector<std::pair<double, double>> referenceDftFilter(std::vector<std::pair<double, double>> data)
+{
+  int n = data.size();
+  //Z(j,k) is w^(jk)/sqrt(n), and w^(jk) only depends on jk mod n
+  std::vector<std::complex<double>> w(n);
+  for(int m = 0; m < n; m++)
+    w[m] = std::polar(1.0, -2*M_PI*m/n);
+
+  std::vector<std::complex<double>> c(n);
+  for(int j = 0; j < n; j++)
+  {
+    std::complex<double> sum = 0;
+    for(int k = 0; k < n; k++)
+      sum += w[(long long)j*k % n]*data[k].second;
+    c[j] = sum/sqrt(n)*exp((-4*M_LN2*j*j) / pow(n, 1.5));
+  }
+  for(int j = 0; j < n; j++)
+  {
+    std::complex<double> sum = 0;
+    for(int k = 0; k < n; k++)
+      sum += std::conj(w[(long long)j*k % n])*c[k];
+    data[j].second = (sum/sqrt(n)).real();
+  }
+  return data;
+}
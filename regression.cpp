@@ -0,0 +1,606 @@
+//regression tests for the analysis
+//runs the bundled datasets and synthetic spectra through the analysis and compares the peaks against golden results
+//also cross-checks the faster code paths against the reference implementations in reference.cpp
+//usage: ./nmrRegression [--update]
+//--update rewrites the golden results from the current code instead of comparing against them
+#include "CubicSpline.h"
+#include "structs.h"
+#include "prototypes.h"
+#include "nmr.h"
+#include "queue.h"
+#include "NoiseEstimate.h"
+#include "gaussLegendre.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <map>
+#include <functional>
+#include <thread>
+#include <atomic>
+
+#define GOLDEN_FILE "golden.txt"
+
+//how far each field of a peak may drift from its golden value
+//begin, end and location are absolute (ppm), area is relative to the golden area
+#define BEGIN_TOLERANCE 1e-6
+#define END_TOLERANCE 1e-6
+#define LOCATION_TOLERANCE 1e-6
+#define AREA_TOLERANCE 1e-5
+#define HYDROGEN_TOLERANCE 0
+
+//a spectrum and the options used to analyze it
+//the spectrum is read from inputFile, or generated by syntheticSpectrum if inputFile is empty
+//drift is the height of a sloped baseline added to the spectrum, to test the automatic baseline corrections
+//if sameAs names another test case, the peaks are compared against its golden results instead of their own,
+//which is how the single precision filters are held to the same tolerances as the double precision ones
+struct testCase
+{
+  std::string name;
+  configuration config;
+  int numPoints, numPeaks;
+  double noiseLevel;
+  double drift = 0;
+  std::string sameAs = "";
+};
+
+//makes a configuration with the given options
+configuration makeConfig(std::string inputFile, double baseline, int filterType, int filterSize, int numPasses, int integrationTechnique, int peakModel = 0, int peakDetection = 0, int baselineMode = 0, double minSnr = 0, int precision = 0)
+{
+  configuration config;
+  config.inputFile = inputFile;
+  config.baseline = baseline;
+  config.tolerance = 1e-5;
+  config.filterType = filterType;
+  config.filterSize = filterSize;
+  config.numPasses = numPasses;
+  config.integrationTechnique = integrationTechnique;
+  config.peakModel = peakModel;
+  config.peakDetection = peakDetection;
+  config.baselineMode = baselineMode;
+  config.minSnr = minSnr;
+  config.quadratureOrder = 2;
+  config.kronrodOrder = 7;
+  config.precision = precision;
+  return config;
+}
+
+std::vector<testCase> testCases()
+{
+  return {
+    {"testdata-dft-adaptive", makeConfig("testdata.dat", 1650, 3, 0, 0, 0), 0, 0, 0},
+    {"testdata-boxcar-romberg", makeConfig("testdata.dat", 1650, 1, 5, 2, 1), 0, 0, 0},
+    {"testdata-sg-newtoncotes", makeConfig("testdata.dat", 1650, 2, 11, 1, 2), 0, 0, 0},
+    {"testdata-none-gauss", makeConfig("testdata.dat", 1650, 0, 0, 0, 3), 0, 0, 0},
+    {"testdata-boxcar-adaptive-multiplets", makeConfig("testdata.dat", 1650, 1, 5, 2, 0, 0, 2), 0, 0, 0},
+    {"testdata2-dft-adaptive", makeConfig("testdata2.dat", 1650, 3, 0, 0, 0), 0, 0, 0},
+    {"testdata2-dft-adaptive-snr", makeConfig("testdata2.dat", 1650, 3, 0, 0, 0, 0, 0, 0, 5), 0, 0, 0},
+    {"synthetic-none-adaptive", makeConfig("", 70, 0, 0, 0, 0), 4096, 12, 10},
+    {"synthetic-boxcar-romberg", makeConfig("", 70, 1, 5, 3, 1), 4096, 12, 10},
+    {"synthetic-boxcar-romberg-single", makeConfig("", 70, 1, 5, 3, 1, 0, 0, 0, 0, 1), 4096, 12, 10, 0, "synthetic-boxcar-romberg"},
+    {"synthetic-sg-gauss", makeConfig("", 70, 2, 5, 2, 3), 4096, 12, 10},
+    {"synthetic-sg-gauss-single", makeConfig("", 70, 2, 5, 2, 3, 0, 0, 0, 0, 1), 4096, 12, 10, 0, "synthetic-sg-gauss"},
+    {"synthetic-dft-newtoncotes", makeConfig("", 70, 3, 0, 0, 2), 1024, 6, 10},
+    {"synthetic-boxcar-adaptive-lorentzian", makeConfig("", 70, 1, 5, 1, 0, 1), 4096, 12, 10},
+    {"synthetic-drift-boxcar-adaptive-polynomial", makeConfig("", 70, 1, 5, 1, 0, 0, 0, 1), 4096, 12, 10, 200},
+    {"synthetic-drift-boxcar-adaptive-als", makeConfig("", 70, 1, 5, 1, 0, 0, 0, 2), 4096, 12, 10, 200},
+    {"synthetic-lowbaseline-boxcar-adaptive-snr", makeConfig("", 45, 1, 5, 1, 0, 0, 0, 0, 10), 4096, 12, 10},
+  };
+}
+
+std::vector<std::pair<double, double>> loadData(testCase t)
+{
+  if(!t.config.inputFile.empty())
+    return readData(t.config.inputFile);
+  auto data = syntheticSpectrum(t.numPoints, t.numPeaks, t.noiseLevel, 335);
+  //a baseline that rises from 0 at the right of the spectrum to drift at the left, with a slight curve
+  for(auto & point : data)
+  {
+    double u = (point.first + 2)/14;
+    point.second += t.drift*u*(0.5 + 0.5*u);
+  }
+  return data;
+}
+
+//reads in the golden results, keyed by the name of the test case
+std::map<std::string, std::vector<peak>> readGolden(std::string fileName)
+{
+  std::map<std::string, std::vector<peak>> golden;
+  std::ifstream file(fileName);
+  std::string name;
+  int numPeaks;
+  while(file >> name >> numPeaks)
+  {
+    std::vector<peak> peaks(numPeaks);
+    for(peak & p : peaks)
+      file >> p.begin >> p.end >> p.location >> p.area >> p.numHydrogens;
+    golden[name] = peaks;
+  }
+  return golden;
+}
+
+void writeGolden(std::string fileName, std::vector<std::pair<std::string, std::vector<peak>>> results)
+{
+  std::ofstream file(fileName);
+  file.precision(std::numeric_limits<double>::max_digits10);
+  for(auto & result : results)
+  {
+    file << result.first << " " << result.second.size() << std::endl;
+    for(peak & p : result.second)
+      file << p.begin << " " << p.end << " " << p.location << " " << p.area << " " << p.numHydrogens << std::endl;
+  }
+}
+
+//compares one field of a peak against its golden value
+//returns a description of the difference, or an empty string if it's within tolerance
+std::string compareField(std::string field, int peakNumber, double actual, double expected, double tolerance)
+{
+  if(fabs(actual - expected) <= tolerance)
+    return "";
+  std::stringstream out;
+  out.precision(10);
+  out << "peak " << peakNumber << " " << field << " is " << actual << ", expected " << expected << " (tolerance " << tolerance << ")";
+  return out.str();
+}
+
+//compares peaks against the golden peaks and returns every difference that is out of tolerance
+std::vector<std::string> comparePeaks(std::vector<peak> actual, std::vector<peak> expected)
+{
+  std::vector<std::string> failures;
+  if(actual.size() != expected.size())
+  {
+    failures.push_back("found " + std::to_string(actual.size()) + " peaks, expected " + std::to_string(expected.size()));
+    return failures;
+  }
+
+  for(int i = 0; i < actual.size(); i++)
+  {
+    peak a = actual[i];
+    peak e = expected[i];
+    failures.push_back(compareField("begin", i+1, a.begin, e.begin, BEGIN_TOLERANCE));
+    failures.push_back(compareField("end", i+1, a.end, e.end, END_TOLERANCE));
+    failures.push_back(compareField("location", i+1, a.location, e.location, LOCATION_TOLERANCE));
+    failures.push_back(compareField("area", i+1, a.area, e.area, AREA_TOLERANCE*fabs(e.area)));
+    failures.push_back(compareField("hydrogens", i+1, a.numHydrogens, e.numHydrogens, HYDROGEN_TOLERANCE));
+  }
+  failures.erase(std::remove(failures.begin(), failures.end(), ""), failures.end());
+  return failures;
+}
+
+//a check of a fast code path against its reference implementation
+//check returns the largest difference between the two on the data it is given
+struct oracleCheck
+{
+  std::string name;
+  std::function<double(std::vector<std::pair<double, double>>)> check;
+  double tolerance;
+};
+
+//the largest difference between the area of a peak found with integrationTechnique and its exact area
+//differences are relative to the largest peak, since the tiny areas of noise peaks are dominated by rounding error
+double integrationError(std::vector<std::pair<double, double>> data, int integrationTechnique)
+{
+  CubicSpline spline(data);
+  std::vector<double> roots = findRoots(spline);
+  double error = 0;
+  double maxArea = 0;
+  for(int i = 0; i+1 < roots.size(); i+=2)
+  {
+    double area = integrate(roots[i], roots[i+1], spline, integrationTechnique, 1e-8, 2, 7);
+    double exact = exactIntegral(spline, roots[i], roots[i+1]);
+    error = std::max(error, fabs(area - exact));
+    maxArea = std::max(maxArea, fabs(exact));
+  }
+  return error/maxArea;
+}
+
+//the largest difference between the area of a peak found with integrationTechnique and with its original implementation
+//both stop at the same tolerance, so they differ by about as much as each differs from the exact area
+double baselineIntegrationError(std::vector<std::pair<double, double>> data, int integrationTechnique)
+{
+  CubicSpline spline(data);
+  std::vector<double> roots = findRoots(spline);
+  double error = 0;
+  double maxArea = 0;
+  for(int i = 0; i+1 < roots.size(); i+=2)
+  {
+    double area = integrate(roots[i], roots[i+1], spline, integrationTechnique, 1e-8, 2, 7);
+    double original = referenceIntegrate(roots[i], roots[i+1], spline, integrationTechnique, 1e-8);
+    error = std::max(error, fabs(area - original));
+    maxArea = std::max(maxArea, fabs(original));
+  }
+  return error/maxArea;
+}
+
+//the largest difference between a root found by findRoots and the same root found in closed form as it originally was
+//finding a different number of roots is an infinite difference
+double cubicRootError(std::vector<std::pair<double, double>> data)
+{
+  CubicSpline spline(data);
+  std::vector<double> roots = findRoots(spline);
+  std::vector<double> reference = referenceCubicRoots(spline);
+  if(roots.size() != reference.size())
+    return std::numeric_limits<double>::infinity();
+  double error = 0;
+  for(int i = 0; i < roots.size(); i++)
+    error = std::max(error, fabs(roots[i] - reference[i]));
+  return error;
+}
+
+//the largest difference between the DFT filter and the original dense matrix DFT, relative to the tallest filtered point
+double dftError(std::vector<std::pair<double, double>> data)
+{
+  auto filtered = filter(data, 3, 0, 0, 0);
+  auto reference = referenceDftFilter(data);
+  double error = 0;
+  double maxValue = 0;
+  for(int i = 0; i < reference.size(); i++)
+  {
+    error = std::max(error, fabs(filtered[i].second - reference[i].second));
+    maxValue = std::max(maxValue, fabs(reference[i].second));
+  }
+  return error/maxValue;
+}
+
+//the largest difference between a root found by findRoots and the same root found by brute force
+//finding a different number of roots is an infinite difference
+double rootError(std::vector<std::pair<double, double>> data)
+{
+  CubicSpline spline(data);
+  std::vector<double> roots = findRoots(spline);
+  std::vector<double> reference = referenceFindRoots(spline);
+  if(roots.size() != reference.size())
+    return std::numeric_limits<double>::infinity();
+  double error = 0;
+  for(int i = 0; i < roots.size(); i++)
+    error = std::max(error, fabs(roots[i] - reference[i]));
+  return error;
+}
+
+//the largest difference between the intensities filtered in single and in double precision
+//differences are relative to the tallest filtered point, since single precision keeps about 7 significant digits of each one
+double precisionError(std::vector<std::pair<double, double>> data, int filterType)
+{
+  auto single = filter(data, filterType, 11, 3, 1);
+  auto reference = filter(data, filterType, 11, 3, 0);
+  double error = 0;
+  double maxValue = 0;
+  for(int i = 0; i < reference.size(); i++)
+  {
+    error = std::max(error, fabs(single[i].second - reference[i].second));
+    maxValue = std::max(maxValue, fabs(reference[i].second));
+  }
+  return error/maxValue;
+}
+
+std::vector<oracleCheck> oracleChecks()
+{
+  return {
+    {"root finding vs brute force bisection", rootError, 1e-12},
+    {"adaptive quadrature vs exact integral", [](auto data){ return integrationError(data, 0); }, 1e-6},
+    {"Romberg vs exact integral", [](auto data){ return integrationError(data, 1); }, 1e-6},
+    {"Gaussian quadrature vs exact integral", [](auto data){ return integrationError(data, 3); }, 1e-12},
+    //the closed form roots of cubics in x lose digits to cancellation, and the original 512 point rule integrates
+    //across the knots where the spline isn't smooth, so those two oracles are only good to about 1e-7
+    {"root finding vs original closed form cubic roots", cubicRootError, 1e-6},
+    {"adaptive quadrature vs original adaptive Simpson", [](auto data){ return baselineIntegrationError(data, 0); }, 1e-7},
+    {"Romberg vs original Romberg", [](auto data){ return baselineIntegrationError(data, 1); }, 1e-12},
+    {"Newton-Cotes vs original Newton-Cotes", [](auto data){ return baselineIntegrationError(data, 2); }, 1e-12},
+    {"Gaussian quadrature vs original 512 point rule", [](auto data){ return baselineIntegrationError(data, 3); }, 1e-6},
+    {"DFT filter vs original dense DFT", dftError, 1e-12},
+    {"single precision boxcar filter vs double", [](auto data){ return precisionError(data, 1); }, 1e-6},
+    {"single precision Savitzky-Golay filter vs double", [](auto data){ return precisionError(data, 2); }, 1e-6},
+  };
+}
+
+//whether svg is a single svg element whose tags are all closed in order and whose numbers are all finite
+bool wellFormedSvg(const std::string& svg)
+{
+  if(svg.compare(0, 5, "<svg ") != 0 || svg.find("nan") != std::string::npos || svg.find("inf") != std::string::npos)
+    return false;
+  std::vector<std::string> open;
+  for(size_t start = svg.find('<'); start != std::string::npos; start = svg.find('<', start + 1))
+  {
+    size_t end = svg.find('>', start);
+    if(end == std::string::npos)
+      return false;
+    std::string tag = svg.substr(start + 1, end - start - 1);
+    if(tag.empty() || tag.back() == '/')
+      continue;
+    std::string name = tag.substr(0, tag.find(' '));
+    if(name[0] != '/')
+      open.push_back(name);
+    else if(open.empty() || open.back() != name.substr(1))
+      return false;
+    else
+      open.pop_back();
+    //nothing comes after the closing svg tag
+    if(open.empty() && end + 2 != svg.size())
+      return false;
+  }
+  return open.empty();
+}
+
+int main(int argc, char* argv[])
+{
+  bool update = argc > 1 && std::string(argv[1]) == "--update";
+  int numFailures = 0;
+
+  std::vector<std::pair<std::string, std::vector<peak>>> results;
+  auto golden = readGolden(GOLDEN_FILE);
+  for(testCase & t : testCases())
+  {
+    double shift = 0;
+    std::vector<peak> peaks = analyze(loadData(t), t.config, shift);
+    if(t.sameAs.empty())
+      results.push_back({t.name, peaks});
+    if(update)
+      continue;
+
+    std::string goldenName = t.sameAs.empty() ? t.name : t.sameAs;
+    if(golden.count(goldenName) == 0)
+    {
+      std::cout << "FAIL " << t.name << ": no golden results, run ./nmrRegression --update" << std::endl;
+      numFailures++;
+      continue;
+    }
+
+    std::vector<std::string> failures = comparePeaks(peaks, golden[goldenName]);
+    std::cout << (failures.empty() ? "PASS " : "FAIL ") << t.name << std::endl;
+    for(auto & failure : failures)
+      std::cout << "    " << failure << std::endl;
+    numFailures += !failures.empty();
+  }
+
+  if(update)
+  {
+    writeGolden(GOLDEN_FILE, results);
+    std::cout << "Wrote golden results for " << results.size() << " test cases to " << GOLDEN_FILE << std::endl;
+    return 0;
+  }
+
+  //the oracles run on the baseline adjusted data of every synthetic test case
+  for(oracleCheck & oracle : oracleChecks())
+  {
+    double error = 0;
+    for(testCase & t : testCases())
+    {
+      if(!t.config.inputFile.empty())
+        continue;
+      spectrum data = orderSpectrum(loadData(t), -1);
+      double shift = 0;
+      baselineAdjustment(data, t.config.baseline, t.config.baselineMode, shift);
+      error = std::max(error, oracle.check(data.points));
+    }
+    bool pass = error <= oracle.tolerance;
+    std::cout << (pass ? "PASS " : "FAIL ") << oracle.name << " (error " << error << ", tolerance " << oracle.tolerance << ")" << std::endl;
+    numFailures += !pass;
+  }
+
+  //the library has to give the same peaks as the analysis it wraps, and report errors instead of exiting
+  std::vector<std::pair<std::string, bool>> libraryChecks;
+  {
+    testCase t = testCases().front();
+    Analyzer analyzer;
+    std::vector<peak> peaks, expected;
+    double shift = 0, expectedShift = 0;
+    expected = analyze(loadData(t), t.config, expectedShift);
+    bool same = analyzer.configure(t.config) == NMR_OK && analyzer.analyze(loadData(t), peaks, shift) == NMR_OK;
+    same = same && shift == expectedShift && comparePeaks(peaks, expected).empty();
+    libraryChecks.push_back({"Analyzer gives the same peaks as analyze", same});
+
+    configuration invalid = t.config;
+    invalid.peakModel = 7;
+    libraryChecks.push_back({"Analyzer rejects an invalid option", analyzer.configure(invalid) == NMR_INVALID_OPTION});
+    libraryChecks.push_back({"Analyzer rejects a spectrum that is too short", analyzer.analyze({{1, 1}}, peaks, shift) == NMR_INVALID_DATA});
+    //the Savitzky-Golay filter drops points from both ends of the spectrum, so one long enough to filter can be too short to fit
+    configuration smoothing = t.config;
+    smoothing.filterType = 2;
+    smoothing.filterSize = 17;
+    smoothing.numPasses = 1;
+    std::vector<std::pair<double, double>> shortData;
+    for(int i = 0; i < 20; i++)
+      shortData.push_back({10 - 0.5*i, t.config.baseline + (i == 10 ? 100 : 1)});
+    bool rejected = analyzer.configure(smoothing) == NMR_OK;
+    rejected = rejected && analyzer.analyze(std::vector<std::pair<double, double>>(shortData.begin(), shortData.begin() + 10), peaks, shift) == NMR_INVALID_DATA;
+    smoothing.filterSize = 5;
+    smoothing.numPasses = 5;
+    rejected = rejected && analyzer.configure(smoothing) == NMR_OK && analyzer.analyze(shortData, peaks, shift) == NMR_INVALID_DATA;
+    libraryChecks.push_back({"Analyzer rejects a spectrum the filter leaves too short", rejected});
+    invalid = t.config;
+    invalid.inputFile = "missing.dat";
+    analyzer.configure(invalid);
+    libraryChecks.push_back({"Analyzer reports a missing data file", analyzer.analyzeFile(peaks, shift) == NMR_DATA_FILE});
+
+    //a key=value file sets the options it names and a later source overrides them
+    configuration options;
+    std::istringstream optionFile("input = a.dat\nfilter=2 # Savitzky-Golay\n\nfilterSize = 11\ntolerance=1e-8\n");
+    readOptions(optionFile, options, "options");
+    setOption(options, "filterSize", "17");
+    bool parsed = options.inputFile == "a.dat" && options.filterType == 2 && options.filterSize == 17 && options.tolerance == 1e-8 && options.numPasses == 0;
+    libraryChecks.push_back({"key=value options are read and overridden", parsed});
+    char* arguments[] = {(char*)"nmrAnalyzer", (char*)"--tolerance", (char*)"small"};
+    libraryChecks.push_back({"Analyzer rejects a command line option that isn't a number", analyzer.configure(3, arguments) == NMR_INVALID_OPTION});
+
+    //a file name with control characters, quotes and commas still gives a valid JSON string and a single CSV field
+    configuration named = t.config;
+    named.inputFile = "a\r\b\"q,\x01.dat";
+    named.format = "json";
+    std::string json = formatResult(expected, named, expectedShift, 0);
+    named.format = "csv";
+    std::string csv = formatResult(expected, named, expectedShift, 0);
+    bool escaped = json.find("\"a\\u000d\\u0008\\\"q,\\u0001.dat\"") != std::string::npos;
+    escaped = escaped && csv.find("# inputFile,\"a\r\b\"\"q,\x01.dat\"\n") != std::string::npos;
+    libraryChecks.push_back({"reports quote and escape the name of the data file", escaped});
+
+    //the CSV report has the signal to noise ratio and the fitted lines that the JSON one has
+    std::vector<peak> fitted = expected;
+    fitted[0].snr = 12.5;
+    fitted[0].lines = {lineShape{1.5, 2, 0.25, 0.5}, lineShape{1.75, 3, 0.125, 1}};
+    named.minSnr = 3;
+    named.peakModel = 3;
+    csv = formatResult(fitted, named, expectedShift, 0);
+    std::string header = "peak,begin,end,location,area,hydrogens";
+    if(named.peakDetection != 0)
+      header += ",height,width,leftInflection,rightInflection";
+    bool complete = csv.find("\n" + header + ",snr\n") != std::string::npos && csv.find(",12.5\n") != std::string::npos;
+    complete = complete && csv.find("\n\npeak,line,center,height,width,eta\n1,1,1.5,2,0.25,0.5\n1,2,1.75,3,0.125,1\n") != std::string::npos;
+    libraryChecks.push_back({"CSV reports have the signal to noise ratio and the fitted lines", complete});
+
+    //the debugging graph of the first test case is a well formed SVG with a dot for every point and a region for every peak
+    std::vector<std::pair<double, double>> points = orderSpectrum(loadData(t), -1).points;
+    CubicSpline spline(spectrum{points, -1});
+    std::string svg = renderGraph(points, nullptr, {});
+    bool drawn = wellFormedSvg(svg);
+    svg = renderGraph(points, &spline, expected);
+    drawn = drawn && wellFormedSvg(svg) && svg.find("<polyline") != std::string::npos;
+    size_t dots = 0, regions = 0;
+    for(size_t at = svg.find("<circle"); at != std::string::npos; at = svg.find("<circle", at + 1))
+      dots++;
+    for(size_t at = svg.find("fill='orange'"); at != std::string::npos; at = svg.find("fill='orange'", at + 1))
+      regions++;
+    libraryChecks.push_back({"the graph of " + t.name + " is well formed SVG", drawn && dots == points.size() && regions == expected.size()});
+
+    //a file that can't be read is still passed to onResult as a failure, and the rest of the batch goes on
+    analyzer.configure(t.config);
+    pipelineStats stats;
+    std::vector<fileResult> results;
+    bool reported = analyzer.analyzeFiles({"missing.dat"}, [&](const fileResult& result){ results.push_back(result); }, stats) == NMR_OK;
+    reported = reported && results.size() == 1 && results[0].code == NMR_DATA_FILE && stats.filesFailed == 1 && stats.filesDone == 0;
+    libraryChecks.push_back({"analyzeFiles reports a missing data file", reported});
+  }
+
+  //the bands the asymmetric least squares baseline uses have to be those of D^T*D built densely, down to 3 points
+  {
+    bool same = true;
+    for(int n = 3; n <= 8; n++)
+    {
+      std::vector<double> D((n-2)*n, 0.0), dense(n*n, 0.0);
+      for(int j = 0; j+2 < n; j++)
+      {
+        D[j*n+j] = 1;
+        D[j*n+j+1] = -2;
+        D[j*n+j+2] = 1;
+      }
+      for(int r = 0; r < n; r++)
+        for(int c = 0; c < n; c++)
+          for(int j = 0; j+2 < n; j++)
+            dense[r*n+c] += D[j*n+r]*D[j*n+c];
+      std::vector<double> d0, d1, d2;
+      secondDifferencePenalty(n, d0, d1, d2);
+      for(int r = 0; r < n; r++)
+        for(int c = 0; c < n; c++)
+        {
+          double band = c == r ? d0[r] : c == r+1 ? d1[r] : r == c+1 ? d1[c] : c == r+2 ? d2[r] : r == c+2 ? d2[c] : 0;
+          same = same && band == dense[r*n+c];
+        }
+    }
+    libraryChecks.push_back({"the baseline's second difference penalty matches a dense D^T*D", same});
+  }
+
+  //the largest Kronrod rule allowed has to be as good as the small ones: the rule itself integrates a cubic exactly,
+  //and adaptive quadrature with it gives the exact areas of the peaks of a spline, which is cubic between its knots
+  {
+    const kronrodRule& rule = getKronrodRule(MAX_QUADRATURE_ORDER);
+    double cubic = 0, gaussCubic = 0;
+    for(int i = 0; i < rule.nodes.size(); i++)
+    {
+      double x = rule.nodes[i];
+      cubic += rule.weights[i]*(((4*x - 3)*x + 2)*x + 1);
+      if(i%2 == 1)
+        gaussCubic += rule.gaussWeights[i/2]*(((4*x - 3)*x + 2)*x + 1);
+    }
+    //the integral of 4x^3 - 3x^2 + 2x + 1 over [-1,1] is 0 - 2 + 0 + 2
+    bool exact = fabs(cubic) < 1e-12 && fabs(gaussCubic) < 1e-12;
+
+    std::vector<std::pair<double, double>> wave;
+    for(int i = 0; i <= 400; i++)
+      wave.push_back({i*0.05, sin(i*0.05)});
+    CubicSpline spline(wave);
+    std::vector<double> roots = findRoots(spline);
+    for(int i = 0; i+1 < roots.size(); i+=2)
+    {
+      double area = integrate(roots[i], roots[i+1], spline, 0, 1e-8, 2, MAX_QUADRATURE_ORDER);
+      double expected = exactIntegral(spline, roots[i], roots[i+1]);
+      exact = exact && std::isfinite(area) && fabs(area - expected) <= 1e-9*std::max(1.0, fabs(expected));
+    }
+    libraryChecks.push_back({"the " + std::to_string(2*MAX_QUADRATURE_ORDER+1) + " point Kronrod rule integrates cubics exactly", exact && roots.size() >= 2});
+  }
+
+  //the noise estimate kept up to date point by point has to be exactly the one estimateNoise finds from scratch
+  {
+    std::vector<std::pair<double, double>> data = syntheticSpectrum(4096, 12, 10, 7);
+    for(auto & point : data)
+      point.second -= 70;
+    NoiseEstimate tracked(data);
+    bool same = true;
+    for(int step = 0; step < 2000 && same; step++)
+    {
+      //the changes move values across zero and onto values that are already there
+      int i = (step*7919) % data.size();
+      double value = step % 3 == 0 ? data[(step*104729) % data.size()].second : data[i].second + ((step % 5) - 2.5)*4;
+      tracked.replace(data[i].second, value);
+      data[i].second = value;
+      double floor = 0, expectedFloor = 0;
+      double noise = tracked.estimate(floor);
+      same = noise == estimateNoise(data, expectedFloor) && floor == expectedFloor;
+    }
+    libraryChecks.push_back({"the noise estimate kept up to date matches estimateNoise", same});
+  }
+
+  //the pipeline's queue has to hand over every item exactly once, with several threads pushing and popping a small queue
+  {
+    const int numThreads = 3, itemsPerThread = 20000;
+    BoundedQueue<long long> queue(4);
+    std::atomic<long long> sum(0), count(0);
+    std::vector<std::thread> producers, consumers;
+    for(int t = 0; t < numThreads; t++)
+    {
+      producers.emplace_back([&, t]{ for(int i = 1; i <= itemsPerThread; i++) queue.push((long long)t*itemsPerThread + i); });
+      consumers.emplace_back([&]{ long long item; while(queue.pop(item)) { sum += item; count++; } });
+    }
+    for(auto & thread : producers)
+      thread.join();
+    queue.close();
+    for(auto & thread : consumers)
+      thread.join();
+    long long n = (long long)numThreads*itemsPerThread;
+    libraryChecks.push_back({"the lock-free queue passes every item on once", count == n && sum == n*(n+1)/2});
+  }
+
+  //updating a window of intensities has to give the same peaks as analyzing the updated spectrum from scratch
+  //the windows are in the middle, near the start, where a boxcar filter wraps around, and at the end, where a new peak appears
+  for(testCase & t : testCases())
+  {
+    if(!t.sameAs.empty())
+      continue;
+    Analyzer analyzer;
+    std::vector<peak> peaks, expected;
+    double shift = 0, expectedShift = 0;
+    std::vector<std::pair<double, double>> data = loadData(t);
+    int n = data.size();
+    bool same = analyzer.configure(t.config) == NMR_OK && analyzer.analyzeIncremental(data, peaks, shift) == NMR_OK;
+    std::vector<std::pair<int, int>> windows = {{n/2 - 20, 40}, {3, 10}, {n - 20, 20}};
+    for(auto & window : windows)
+    {
+      std::vector<double> intensities;
+      for(int i = window.first; i < window.first + window.second; i++)
+      {
+        data[i].second = window.first == n - 20 ? t.config.baseline + 100 : 1.5*data[i].second;
+        intensities.push_back(data[i].second);
+      }
+      same = same && analyzer.update(window.first, intensities, peaks, shift) == NMR_OK;
+      expected = analyze(data, t.config, expectedShift);
+      same = same && shift == expectedShift && comparePeaks(peaks, expected).empty();
+    }
+    libraryChecks.push_back({"incremental updates of " + t.name + " match a full analysis", same});
+  }
+  for(auto & check : libraryChecks)
+  {
+    std::cout << (check.second ? "PASS " : "FAIL ") << check.first << std::endl;
+    numFailures += !check.second;
+  }
+
+  std::cout << std::endl << (numFailures == 0 ? "All tests passed." : std::to_string(numFailures) + " tests failed.") << std::endl;
+  return numFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,78 @@
+//functions for putting data points in order by x-value
+//spectrometers export their points in order already, so the data is only sorted when it has to be
+#include "structs.h"
+#include "prototypes.h"
+#include <vector>
+#include <algorithm>
+#include <thread>
+
+//below this many points one thread sorts faster than it takes to start more
+#define PARALLEL_SORT_MIN 65536
+
+//returns 1 if the points are in ascending order, -1 if they are in descending order and 0 if they are in neither
+//points with the same x-value are ordered by their y-value, the same way std::sort orders them
+int findOrder(const std::vector<std::pair<double, double>>& points)
+{
+  bool ascending = true, descending = true;
+  for(int i = 0; i+1 < points.size() && (ascending || descending); i++)
+  {
+    ascending = ascending && !(points[i+1] < points[i]);
+    descending = descending && !(points[i] < points[i+1]);
+  }
+  return ascending ? 1 : descending ? -1 : 0;
+}
+
+//sorts the points in ascending order
+//large inputs are split into one chunk per thread, the chunks are sorted at the same time
+//and then neighbouring chunks are merged in parallel until only one is left
+//numThreads limits how many chunks there are, 0 uses one per core
+void parallelSort(std::vector<std::pair<double, double>>& points, int numThreads)
+{
+  if(numThreads <= 0)
+    numThreads = std::thread::hardware_concurrency();
+  int numChunks = std::max(1, std::min<int>(numThreads, points.size()/PARALLEL_SORT_MIN));
+  if(numChunks == 1)
+  {
+    std::sort(points.begin(), points.end());
+    return;
+  }
+
+  //bounds[i] is where the ith chunk starts
+  std::vector<int> bounds(numChunks+1);
+  for(int i = 0; i <= numChunks; i++)
+    bounds[i] = (long long)points.size()*i/numChunks;
+
+  std::vector<std::thread> threads;
+  for(int i = 0; i < numChunks; i++)
+    threads.emplace_back([&, i]{ std::sort(points.begin() + bounds[i], points.begin() + bounds[i+1]); });
+  for(auto & thread : threads)
+    thread.join();
+
+  //each round merges pairs of chunks, halving how many there are
+  for(int width = 1; width < numChunks; width *= 2)
+  {
+    threads.clear();
+    for(int i = 0; i + width < numChunks; i += 2*width)
+    {
+      int first = bounds[i], middle = bounds[i+width], last = bounds[std::min(i + 2*width, numChunks)];
+      threads.emplace_back([&points, first, middle, last]{ std::inplace_merge(points.begin() + first, points.begin() + middle, points.begin() + last); });
+    }
+    for(auto & thread : threads)
+      thread.join();
+  }
+}
+
+//puts the points in order (1=ascending, -1=descending) and records it in the spectrum
+//data that is already monotone only costs one pass to check, and one more to reverse if it runs the wrong way
+spectrum orderSpectrum(std::vector<std::pair<double, double>> points, int order, int numThreads)
+{
+  int current = findOrder(points);
+  if(current == 0)
+  {
+    parallelSort(points, numThreads);
+    current = 1;
+  }
+  if(current != order)
+    std::reverse(points.begin(), points.end());
+  return {std::move(points), order};
+}
@@ -1,14 +1,116 @@
 #pragma once
 #include <string>
+#include <vector>
+#include <utility>
 struct configuration
 {
   std::string inputFile, outputFile;
-  double baseline, tolerance;
-  int filterType, filterSize, numPasses, integrationTechnique;
+  double baseline = 0, tolerance = 1e-5;
+  int filterType = 0, filterSize = 0, numPasses = 0, integrationTechnique = 0;
+  int peakModel = 0; //0=none, 1=Lorentzian, 2=Gaussian, 3=pseudo-Voigt
+  int peakDetection = 0; //0=midpoint, 1=apex, 2=apex and split multiplets
+  int baselineMode = 0; //0=constant, 1=polynomial, 2=asymmetric least squares
+  double minSnr = 0; //peaks whose signal to noise ratio is below this are ignored, 0 keeps every peak
+  int quadratureOrder = 2; //points per spline segment for Gaussian quadrature, 2 integrates every cubic exactly
+  int kronrodOrder = 7; //adaptive quadrature uses the Kronrod extension of the Gauss rule with this many points, 7 gives the 15 point rule
+  int precision = 0; //0=double, 1=single precision buffers for the boxcar and Savitzky-Golay filters
+  int numThreads = 0; //threads used to sort the data and fit the peaks, or workers for several files, 0 uses every core
+  std::string format; //"text", "json" or "csv", empty chooses by the extension of outputFile
+  std::string watchDirectory; //if it isn't empty, every .dat file that appears in this directory is analyzed
+  std::vector<std::string> dataFiles; //if there are any, each one is analyzed and gets a report next to it, instead of inputFile
+};
+
+//what went wrong when the analysis fails, NMR_OK means nothing did
+enum errorCode
+{
+  NMR_OK = 0,
+  NMR_CONFIG_FILE, //the configuration file couldn't be read
+  NMR_INVALID_OPTION, //an option is out of range
+  NMR_DATA_FILE, //the data file couldn't be read
+  NMR_INVALID_DATA, //the spectrum is too short or has values that aren't finite
+  NMR_NUMERICAL, //a numerical method failed
+  NMR_OUTPUT_FILE, //the results couldn't be written
+  NMR_OUT_OF_MEMORY
+};
+
+//thrown by the analysis when it fails, and turned into an errorCode by the Analyzer
+struct nmrException
+{
+  errorCode code;
+  std::string message;
+};
+
+//what happened to one file analyzed in a batch or in watch mode
+//the times are in seconds, and latency is from when the file was noticed to when its report was written
+struct fileResult
+{
+  std::string dataFile, reportFile;
+  errorCode code = NMR_OK;
+  std::string error; //what went wrong, if code isn't NMR_OK
+  int numPeaks = 0;
+  //writeQueueTime is how long the results waited for the writer after they were analyzed
+  double readTime = 0, queueTime = 0, analyzeTime = 0, writeQueueTime = 0, writeTime = 0, latency = 0;
+};
+
+//totals over every file analyzed in a batch or in watch mode
+struct pipelineStats
+{
+  int filesDone = 0, filesFailed = 0;
+  //how many spectra can wait for a worker, and the most that ever did
+  int queueCapacity = 0, maxQueueDepth = 0;
+  //how many times reading had to wait for a worker to make room in the queue, and for how long in total
+  int stalls = 0;
+  double stallTime = 0;
+  //the same for the results waiting for the writer, and how many times a worker had to wait for it to make room
+  int writeQueueCapacity = 0, maxWriteQueueDepth = 0, writeStalls = 0;
+  double totalLatency = 0, maxLatency = 0;
+};
+
+//data points together with the order of their x-values, so later stages know they don't have to sort them
+struct spectrum
+{
+  std::vector<std::pair<double, double>> points;
+  int order = 0; //1=ascending, -1=descending, 0=not known to be in order
+  double xOffset = 0; //the true x-value of a point is its stored x-value minus this
+};
+
+//the nodes and weights of a quadrature rule on [-1,1], with the nodes in ascending order
+struct quadratureRule
+{
+  std::vector<double> nodes, weights;
+};
+
+//the 2n+1 point Kronrod extension of the n point Gauss-Legendre rule on [-1,1], with the nodes in ascending order
+//the Gauss nodes are the odd ones, and gaussWeights are their weights in the Gauss rule
+struct kronrodRule
+{
+  std::vector<double> nodes, weights, gaussWeights;
+};
+
+//a single line fitted to a peak
+//width is the half width at half maximum and eta is the Lorentzian fraction of a pseudo-Voigt line
+struct lineShape
+{
+  double center, height, width, eta;
 };
 
 struct peak
 {
   double begin, end, location, area;
   int numHydrogens;
+  //only filled in when the apex is found from the spline's derivative
+  //height is the height of the apex and width is the full width at half of it
+  double height = 0, width = 0, leftInflection = 0, rightInflection = 0;
+  double snr = 0; //signal to noise ratio, only filled in when peaks are picked by it
+  std::vector<lineShape> lines; //only filled in when peaks are fitted
+};
+
+//the part of the spline between a pair of its roots, and the peaks found there
+//kept between updates of an incremental analysis so regions the update didn't touch aren't integrated again
+struct peakRegion
+{
+  double begin, end;
+  double height = 0; //the tallest point in the region, only needed when peaks are picked by their signal to noise ratio
+  bool done = false; //whether peaks has been filled in
+  std::vector<peak> peaks; //usually one peak, or one per line if multiplets are split
 };
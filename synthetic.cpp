@@ -0,0 +1,60 @@
+//generates synthetic nmr spectra for benchmarking and testing
+#include <vector>
+#include <utility>
+#include <random>
+#include <algorithm>
+
+//range of the synthetic spectrum in ppm
+#define SYNTHETIC_MAX_X 12.0
+#define SYNTHETIC_MIN_X -2.0
+//height of the TMS peak, the other peaks are a fraction of this
+#define SYNTHETIC_HEIGHT 1000.0
+
+//value of a Lorentzian with height h and half width at half maximum w centered at x0
+double lorentzian(double x, double x0, double h, double w)
+{
+  double u = (x - x0)/w;
+  return h/(1 + u*u);
+}
+
+//generates a spectrum of numPoints evenly spaced points made of a TMS peak and numPeaks random Lorentzian peaks
+//gaussian noise with a standard deviation of noiseLevel is added to every point
+//the points are returned from most positive to most negative x, the same order a spectrometer exports them in
+std::vector<std::pair<double, double>> syntheticSpectrum(int numPoints, int numPeaks, double noiseLevel, unsigned seed)
+{
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  std::normal_distribution<double> noise(0.0, noiseLevel > 0 ? noiseLevel : 1.0);
+
+  double range = SYNTHETIC_MAX_X - SYNTHETIC_MIN_X;
+  double h = range/(numPoints-1); //spacing between points
+
+  //each peak is a center, a height, and a width
+  //widths are kept at least a few points wide so every peak is resolved by the spline
+  struct lorentzianPeak { double center, height, width; };
+  std::vector<lorentzianPeak> lorentzians;
+  lorentzians.reserve(numPeaks+1);
+  double minWidth = std::max(0.004, 3*h);
+  lorentzians.push_back({SYNTHETIC_MAX_X - 0.05*range, SYNTHETIC_HEIGHT, minWidth}); //TMS
+  for(int i = 0; i < numPeaks; i++)
+  {
+    double center = SYNTHETIC_MAX_X - (0.1 + 0.85*uniform(generator))*range;
+    double height = SYNTHETIC_HEIGHT*(0.1 + 0.9*uniform(generator));
+    double width = minWidth*(1 + 2*uniform(generator));
+    lorentzians.push_back({center, height, width});
+  }
+
+  std::vector<std::pair<double, double>> data;
+  data.reserve(numPoints);
+  for(int i = 0; i < numPoints; i++)
+  {
+    double x = SYNTHETIC_MAX_X - i*h;
+    double y = 0;
+    for(auto & l : lorentzians)
+      y += lorentzian(x, l.center, l.height, l.width);
+    if(noiseLevel > 0)
+      y += noise(generator);
+    data.push_back({x, y});
+  }
+  return data;
+}
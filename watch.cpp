@@ -0,0 +1,89 @@
+//functions for watch mode, which analyzes every spectrum that appears in a directory
+//the thread waiting for new files with inotify is the pipeline's reader, so the files are read as they appear
+//while the ones before them are analyzed and have their reports written
+#include "structs.h"
+#include "prototypes.h"
+#include "pipeline.h"
+#include <string>
+#include <atomic>
+#include <functional>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+//how often the reader checks whether it has been told to stop, in milliseconds
+#define WATCH_POLL_INTERVAL 100
+
+#ifdef __linux__
+//owns the inotify file descriptor, so it is closed however watchDirectory returns or throws
+struct inotifyHandle
+{
+  int fd;
+  inotifyHandle() : fd(inotify_init1(IN_CLOEXEC)) {}
+  ~inotifyHandle()
+  {
+    if(fd >= 0)
+      close(fd);
+  }
+  inotifyHandle(const inotifyHandle&) = delete;
+  inotifyHandle& operator=(const inotifyHandle&) = delete;
+};
+
+//watches directory for .dat files that are written or moved into it, until stop is set
+//each one is analyzed with the options in config on numThreads workers (0 uses every core),
+//and its report is written atomically next to it in the format chosen by config.format
+//onResult is called once for every file, by one thread at a time, and stats are kept up to date as files finish
+void watchDirectory(const configuration& config, std::string directory, const std::atomic<bool>& stop, const std::function<void(const fileResult&)>& onResult, pipelineStats& stats)
+{
+  inotifyHandle inotify;
+  int fd = inotify.fd;
+  if(fd < 0)
+    throw nmrException{NMR_DATA_FILE, "could not start watching for files"};
+  //files are announced once they are closed after writing, or when they are renamed into the directory complete
+  if(inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    throw nmrException{NMR_DATA_FILE, "could not watch directory " + directory};
+
+  Pipeline pipeline(config, onResult, stats);
+
+  //inotify events are a header followed by a name, so the buffer is aligned like the header
+  alignas(inotify_event) char buffer[64*1024];
+  pollfd watched = {fd, POLLIN, 0};
+  while(!stop)
+  {
+    //a signal, such as the SIGINT that sets stop, interrupts poll and read, and the loop goes back to check stop
+    int ready = poll(&watched, 1, WATCH_POLL_INTERVAL);
+    if(ready < 0 && errno != EINTR)
+      throw nmrException{NMR_DATA_FILE, "could not wait for files in " + directory};
+    if(ready <= 0)
+      continue;
+    ssize_t length = read(fd, buffer, sizeof(buffer));
+    if(length < 0)
+    {
+      if(errno == EINTR || errno == EAGAIN)
+        continue;
+      throw nmrException{NMR_DATA_FILE, "could not read the files added to " + directory};
+    }
+    for(ssize_t offset = 0; offset < length; )
+    {
+      const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+      offset += sizeof(inotify_event) + event->len;
+      std::string name = event->len > 0 ? event->name : "";
+      if(name.size() < 4 || name.compare(name.size() - 4, 4, ".dat") != 0)
+        continue;
+
+      pipeline.add(directory + "/" + name, pipelineClock::now());
+    }
+  }
+
+  //the spectra already read are still analyzed and written before the pipeline stops
+  pipeline.close();
+}
+#else
+void watchDirectory(const configuration& config, std::string directory, const std::atomic<bool>& stop, const std::function<void(const fileResult&)>& onResult, pipelineStats& stats)
+{
+  throw nmrException{NMR_INVALID_OPTION, "watch mode needs inotify, which only Linux has."};
+}
+#endif